@@ -0,0 +1,108 @@
+// Сгенерировано tools/embed_web.py из web/index.html, не править вручную
+#pragma once
+#include <Arduino.h>
+
+#define WEB_INDEX_ETAG "\"b772bd3878c4dff2\""
+#define WEB_INDEX_GZ_LEN 1570  // исходный HTML: 3543 байт
+
+const uint8_t WEB_INDEX_GZ[] PROGMEM = {
+  0x1F,0x8B,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0x95,0x57,0x5B,0x6F,0xDC,0x44,
+  0x14,0x7E,0xE7,0x57,0x1C,0xB6,0x42,0xDE,0x15,0x7B,0x4B,0xD2,0x94,0x68,0x6F,0x48,
+  0x6D,0x52,0x81,0xD4,0x92,0x4A,0xCD,0x0B,0x42,0x3C,0xCC,0xDA,0xB3,0xEB,0x69,0xBD,
+  0xF6,0x62,0x8F,0x73,0xA1,0x8A,0x94,0xB6,0x54,0x14,0xB5,0x6A,0x25,0x5E,0xE0,0x15,
+  0xC1,0x0F,0x48,0xD3,0x06,0xD2,0x5B,0xF8,0x0B,0xF6,0x3F,0xE2,0x1B,0xCF,0xD8,0xEB,
+  0xDD,0x24,0x05,0xB4,0xDA,0xB5,0xE7,0xCC,0xB9,0x9F,0xEF,0x9C,0x99,0xED,0x7D,0xBC,
+  0xBE,0x79,0x6D,0xEB,0xEB,0x5B,0x1B,0xE4,0xCA,0x89,0x37,0xE8,0x99,0x5F,0xCE,0x9C,
+  0x41,0x6F,0xC2,0x25,0x23,0xDB,0x65,0x61,0xC4,0x65,0xDF,0x8A,0xE5,0xA8,0xB1,0x66,
+  0x0D,0x7A,0x52,0x48,0x8F,0x0F,0xB6,0xF8,0x84,0x6D,0xDE,0xA6,0xEB,0xC2,0xE3,0x74,
+  0x93,0xF9,0x6C,0xCC,0xC3,0x5E,0x4B,0x6F,0x7D,0xD4,0x8B,0xE4,0x9E,0x7A,0x12,0x0D,
+  0x03,0x67,0x8F,0xEE,0xD1,0x28,0xF0,0x65,0x63,0xC4,0x26,0xC2,0xDB,0xEB,0x50,0xC4,
+  0xFC,0xA8,0x11,0xF1,0x50,0x8C,0xBA,0x34,0x64,0xF6,0xDD,0x71,0x18,0xC4,0xBE,0xD3,
+  0xA1,0x4B,0xA3,0xB6,0xFA,0x74,0xC9,0x0E,0xBC,0x20,0xC4,0x7A,0x65,0x65,0xA5,0x4B,
+  0xFB,0xD0,0xD2,0xB4,0x21,0xCF,0x84,0xCF,0x43,0xE8,0x9A,0xB0,0xDD,0xC6,0x8E,0x70,
+  0xA4,0xDB,0xA1,0xB5,0x76,0x7B,0xBA,0xDB,0x05,0x25,0x1C,0x0B,0xBF,0x43,0xCB,0x58,
+  0x11,0x8B,0x65,0xD0,0xA5,0x29,0x73,0x1C,0xE1,0x8F,0x35,0x6D,0xD1,0xCC,0x48,0x19,
+  0x0E,0x42,0x87,0x87,0x8D,0x90,0x39,0x22,0x8E,0xA0,0x29,0xE3,0x0A,0x76,0x1B,0x91,
+  0xCB,0x9C,0x60,0xA7,0x43,0x6D,0x5A,0x86,0xB2,0xCB,0xF8,0x86,0xE3,0x21,0xAB,0xB6,
+  0xEB,0xD9,0xA7,0xB9,0x54,0xD3,0x1E,0xB9,0x4B,0x75,0x72,0x97,0xE1,0x4D,0xEE,0xEB,
+  0x12,0x53,0x1F,0xBD,0x29,0xFC,0x69,0x2C,0xEB,0x24,0xF9,0xAE,0x64,0x21,0x67,0x75,
+  0x8A,0xB8,0xC7,0x6D,0x50,0x86,0xB1,0x94,0x81,0x0F,0x29,0xE3,0xFF,0x52,0xBB,0xFD,
+  0x49,0xC9,0xD7,0xA5,0xB9,0x68,0x56,0x61,0xBB,0x4D,0x4B,0xAB,0xDA,0xB3,0x39,0x6F,
+  0x2F,0xCF,0x68,0x90,0x02,0x5F,0x14,0x78,0xC2,0xA1,0x4B,0xB6,0x6D,0x9B,0x28,0xC4,
+  0xF7,0x99,0x46,0x23,0x07,0x92,0xF6,0x2C,0x77,0x09,0x2E,0xB8,0x5C,0x8C,0x5D,0x09,
+  0xF1,0xD5,0xCC,0x6A,0xC8,0x21,0xC3,0x3B,0xB4,0xCD,0x43,0x29,0x6C,0xE6,0x69,0xFE,
+  0xC2,0xE1,0xB9,0x04,0xB6,0xDB,0x9F,0x0D,0x55,0x0E,0x4D,0xEC,0x3B,0xAE,0x90,0x7C,
+  0xE6,0x8F,0x1F,0xF8,0x58,0xD9,0x71,0x18,0xA9,0xCD,0x69,0x20,0x7C,0xC9,0xC3,0xAE,
+  0x86,0x80,0xB6,0xB1,0x74,0x65,0xBA,0x5B,0xD6,0xDF,0x71,0x83,0xED,0xAC,0xB4,0x0B,
+  0x56,0x56,0xAF,0x0C,0x0D,0x00,0x2E,0x8D,0x00,0xB3,0x1B,0x22,0x92,0x60,0xF2,0xF0,
+  0x68,0x64,0x00,0x6B,0xC8,0xBD,0x29,0xCF,0x0D,0x16,0x59,0x6C,0x2F,0x8A,0x78,0x02,
+  0x52,0x8E,0x88,0xA6,0x1E,0x03,0xFA,0x46,0x1E,0x87,0xF1,0x3B,0x71,0x24,0xC5,0x68,
+  0xAF,0xA1,0x80,0xC5,0x7D,0xA4,0x21,0x9A,0x32,0x9B,0x37,0x86,0x5C,0xEE,0x70,0xEE,
+  0x77,0x89,0x79,0x62,0xEC,0x37,0x10,0xD7,0x04,0xE9,0xB6,0xB9,0x0E,0xA1,0x30,0xB1,
+  0x56,0xAA,0xC9,0x30,0x40,0x08,0x93,0xB9,0x32,0x70,0xCE,0x0D,0x6E,0x1D,0x14,0x5E,
+  0x42,0xAD,0x3C,0x93,0x43,0xC7,0x5E,0x59,0xBD,0xBC,0xFA,0xE1,0x1C,0x16,0xF6,0x14,
+  0x14,0x34,0x38,0xCE,0x03,0xC2,0x99,0x54,0x2F,0x98,0x3E,0x3F,0xBD,0xF6,0xDA,0xB2,
+  0xE9,0xAF,0x5E,0xCB,0xB4,0x6B,0xAF,0xA5,0xDB,0x5E,0x35,0xED,0xA0,0xE7,0x88,0x6D,
+  0xB2,0x3D,0x16,0x45,0x7D,0xAB,0x68,0x3F,0x0B,0x4C,0xEE,0xD2,0xF9,0xBD,0x0F,0x3A,
+  0x36,0x97,0x07,0xC9,0x6F,0xC9,0x69,0xF2,0x57,0xF2,0x2A,0x39,0x4C,0x1F,0xA4,0x4F,
+  0x5B,0xC9,0x2F,0xC9,0x61,0xF2,0x32,0x3D,0x48,0x1F,0x82,0x78,0xA2,0x48,0x94,0xFE,
+  0x00,0xD2,0xEB,0xE4,0x2D,0x64,0x96,0x21,0x33,0x0A,0xC2,0x09,0x09,0xA7,0x5F,0xB1,
+  0x81,0x4C,0xC9,0xAF,0x63,0x59,0x21,0x66,0x4B,0x11,0xF8,0xFD,0x4A,0x4B,0x13,0x2B,
+  0x84,0x59,0xE4,0x06,0x60,0x9A,0x06,0x91,0xAC,0xA8,0xD1,0xD2,0xF3,0xD8,0x90,0x7B,
+  0xC0,0x55,0xD8,0xAF,0xA8,0x5A,0xFB,0x6C,0xC2,0x2B,0x83,0xE4,0xD7,0xE4,0x5D,0xFA,
+  0xBC,0x30,0x91,0x1C,0x52,0x35,0x79,0x8F,0xF7,0xBF,0xD3,0x83,0xE4,0x24,0x79,0x97,
+  0x1C,0xA7,0x07,0xAA,0x33,0x23,0xD9,0x94,0xBB,0x92,0x40,0x7A,0x9B,0x9C,0x90,0x98,
+  0x20,0x84,0xA6,0x5B,0xEB,0xF4,0x5A,0x99,0xD2,0x4C,0x7D,0xD6,0xC5,0xA4,0x20,0xD6,
+  0xAF,0xA8,0xBE,0xA9,0x64,0x3E,0x16,0x96,0x48,0xFD,0x96,0xD7,0x21,0xFF,0x2E,0x16,
+  0x21,0x77,0x16,0x7D,0x33,0x10,0xAB,0xE8,0xC4,0xBC,0x52,0x1E,0x24,0x7F,0x66,0xBE,
+  0x9C,0x26,0xC7,0xF0,0xEE,0x55,0xF2,0x16,0x0E,0x37,0x5D,0x4A,0x8E,0xD2,0xFB,0xE9,
+  0x03,0xF8,0x7A,0x94,0x3E,0xC5,0xF3,0x98,0xC0,0x72,0x08,0xD2,0x7D,0x30,0x1F,0x51,
+  0xF2,0x42,0x45,0x04,0xFA,0xA9,0x5A,0xBC,0xC1,0xE2,0x0D,0xA9,0xB7,0x52,0x60,0xC9,
+  0xF1,0x7C,0x04,0x45,0xB7,0x67,0xC9,0x35,0x6E,0x18,0xBF,0x8B,0x65,0xE1,0x36,0xA6,
+  0xB7,0xE1,0xCF,0x84,0x4D,0xEB,0xEB,0xF8,0xA3,0x78,0x38,0x11,0x79,0x08,0x45,0x6D,
+  0x29,0xF9,0x23,0x2F,0xA4,0xE6,0x56,0x10,0x52,0xD5,0xCC,0x81,0x90,0x3E,0x4C,0x7F,
+  0x82,0x63,0x2A,0xAA,0x23,0xBC,0x3F,0xC3,0xEA,0x04,0x71,0xE5,0xC5,0x49,0x9F,0x18,
+  0x04,0xC4,0x5E,0x91,0x5B,0xD5,0xB1,0x15,0xF8,0x12,0x7B,0x4A,0x19,0x30,0xA8,0x4E,
+  0x13,0x3B,0x14,0x53,0xA9,0xBC,0x1A,0xC5,0x7E,0x86,0x0B,0x1A,0x71,0x69,0xBB,0x0A,
+  0x7F,0x51,0xB5,0x46,0xF7,0xB0,0x43,0x9A,0x54,0xB5,0x5A,0x6A,0x3E,0x58,0xB5,0xA6,
+  0x74,0xB9,0x5F,0xC5,0x54,0x9B,0x06,0x7E,0xC4,0xA9,0x3F,0xA0,0xFC,0xBD,0x79,0x27,
+  0x0A,0xFC,0x6A,0xCD,0x70,0x28,0x9B,0x91,0xDA,0xD6,0x4A,0x08,0x0D,0xE9,0x63,0x66,
+  0x14,0xC3,0xA3,0x4F,0x4E,0x60,0xC7,0x13,0xA4,0xAA,0x39,0xE6,0x72,0xC3,0xE3,0xEA,
+  0xF5,0xEA,0xDE,0x97,0x4E,0xD5,0xCA,0x79,0xAC,0x5A,0xD7,0xC8,0xE6,0x94,0xA6,0xF0,
+  0xD1,0x2C,0x5F,0x6C,0xDD,0xBC,0x01,0x79,0xCB,0x2A,0x6F,0x47,0x4D,0x24,0x68,0x83,
+  0xC1,0x53,0xB5,0x2A,0x1B,0xCE,0x4D,0x63,0x5C,0x95,0x8C,0x6A,0xF8,0x1B,0xBB,0x55,
+  0xCB,0x13,0x33,0x6B,0x04,0xD6,0xA6,0xAA,0xD9,0x35,0x5D,0x4B,0x88,0x29,0x9D,0x4D,
+  0x55,0x60,0xFA,0x94,0x2C,0xAA,0x5A,0x78,0x64,0x24,0x35,0x77,0x33,0xD2,0x70,0x0F,
+  0xD8,0xAF,0x59,0xDD,0x05,0x9B,0x7A,0x58,0x5C,0xC5,0x98,0xBA,0xD8,0xB4,0x2E,0x71,
+  0xD9,0x7C,0x21,0xB5,0xE0,0x85,0x95,0xFC,0xAE,0x20,0xA2,0x5A,0x4B,0xC1,0xC4,0x3A,
+  0x4F,0x22,0x9B,0x2C,0x5F,0x29,0x4F,0xC1,0x3F,0x9B,0x55,0xE7,0xF2,0x06,0xBE,0xED,
+  0x09,0xFB,0x2E,0x38,0x51,0x6C,0x64,0x4C,0xEF,0xA8,0xEA,0x57,0x8B,0x80,0xE7,0xB3,
+  0xC2,0xA6,0x53,0xEE,0x3B,0xD7,0x5C,0xE1,0x39,0xD5,0x42,0x4F,0x89,0xA5,0x28,0x54,
+  0x99,0xD1,0x13,0x05,0xC7,0xBE,0x79,0xD3,0xCF,0xFD,0x32,0xF2,0x16,0x8C,0x67,0xB6,
+  0x4D,0x0D,0xC5,0x88,0xAA,0xC8,0xE7,0x48,0x84,0x93,0xAA,0x95,0xFC,0x9C,0x3E,0x21,
+  0x0C,0xBD,0x23,0xDD,0x99,0xC9,0xFB,0xF4,0x49,0x9D,0xD2,0x1F,0x55,0x03,0x53,0xFA,
+  0x28,0x39,0xC5,0xCB,0x49,0xD6,0xE5,0xE0,0x29,0x25,0x8B,0xF2,0x9A,0xE5,0x55,0xFC,
+  0xDC,0xAA,0xD5,0x16,0xC1,0x89,0x16,0x5B,0x67,0xB8,0x9A,0xF5,0xC9,0xE7,0x3B,0x74,
+  0xDD,0x2C,0xAB,0x33,0x1C,0x1A,0x8A,0x09,0x4F,0x43,0x55,0x29,0xB4,0xEA,0x85,0xEE,
+  0x19,0xB3,0xE9,0x1B,0x1D,0x18,0x38,0xEE,0x99,0x59,0xDB,0x21,0xEB,0xD6,0xE6,0xED,
+  0x2D,0x50,0xD4,0x81,0xD0,0x99,0x99,0xDD,0xAF,0x15,0x89,0xFC,0x40,0x9B,0x29,0x4C,
+  0xA0,0xCD,0xCE,0xB2,0xC6,0x9E,0x9C,0xC7,0x3D,0xE1,0xB8,0xC5,0xB5,0xC3,0xEC,0x95,
+  0xCA,0x44,0x73,0x7D,0x3E,0xA3,0x17,0xE5,0x31,0xC5,0x69,0xB5,0xE8,0xDC,0xE1,0x8A,
+  0x99,0xF3,0x28,0x23,0x23,0xB5,0xB3,0x23,0x01,0x03,0x14,0xDF,0xD7,0x28,0x46,0x36,
+  0x5E,0x91,0xF4,0xF4,0x19,0x4D,0x60,0x59,0x4C,0x59,0x88,0xAB,0xC0,0xC6,0xED,0x5B,
+  0x2B,0xCB,0x18,0xAC,0x90,0x7A,0x0C,0x85,0x0F,0x08,0xD5,0x7B,0x89,0xAA,0xA9,0x73,
+  0x44,0x69,0x79,0x0B,0xE2,0x63,0xB5,0x7F,0x9A,0x4D,0xE3,0x37,0xF8,0xBE,0xAB,0xAB,
+  0x5D,0x18,0xBC,0x8F,0xC5,0x0B,0x08,0x1E,0x40,0xF5,0x73,0x3D,0x9F,0x61,0x15,0x27,
+  0x92,0x2A,0x77,0x19,0x46,0xE6,0xAC,0x53,0x30,0xE2,0xDB,0x68,0x9B,0xBC,0xC6,0xD9,
+  0xA2,0x39,0x0D,0xB3,0xE7,0x3A,0x1F,0x31,0xF8,0x95,0x87,0xAE,0xAB,0xEF,0xEB,0xA6,
+  0xF9,0xE0,0x58,0xCA,0x6A,0x5D,0x6B,0x6E,0x33,0x2F,0xE6,0x65,0xD9,0x7F,0x41,0xCE,
+  0x19,0xDC,0x98,0x53,0x02,0x10,0x50,0xEC,0x57,0xBD,0x60,0x58,0xFD,0xE6,0x42,0xC3,
+  0x39,0xB3,0xB1,0xFB,0xAD,0x42,0x92,0xBE,0xA1,0x59,0x0A,0x0B,0x2D,0xDC,0xBF,0x84,
+  0x6F,0xA1,0x78,0x75,0x2A,0x01,0x30,0x87,0x9F,0x4E,0xC8,0xFF,0x82,0xDF,0x7F,0x06,
+  0xDF,0xC5,0xD0,0xBB,0x00,0x78,0xE7,0xC1,0x6E,0x36,0x0B,0x2E,0xCE,0x40,0x71,0x81,
+  0x41,0x12,0x70,0x79,0xDB,0x50,0x45,0x54,0x73,0x86,0xE3,0x38,0xA8,0x5A,0xFA,0x14,
+  0x45,0x40,0xB3,0xE2,0x67,0x3A,0x0B,0x7D,0x67,0x45,0xD6,0x37,0x6F,0x9A,0xB9,0x7A,
+  0x23,0x60,0x0E,0x77,0x54,0x03,0x17,0xBE,0x41,0x18,0x77,0x37,0x73,0x38,0xE2,0x0C,
+  0xCE,0xAE,0x6D,0xAD,0xEC,0x0F,0xDC,0x47,0xFF,0x00,0x06,0x4F,0x71,0x32,0xD7,0x0D,
+  0x00,0x00,
+};
@@ -2,10 +2,13 @@
 #include <WebServer.h>
 #include <LittleFS.h>
 #include <GyverOLED.h>
-#include <GyverButton.h>
-#include <GyverTimer.h>
 #include <Wire.h>
 #include <math.h>
+#include <new>
+#include <soc/gpio_reg.h>
+#include <esp32/rom/crc.h>
+#include <mbedtls/sha256.h>
+#include "web_index.h"
 
 #define UP_BTN_PIN 19
 #define DOWN_BTN_PIN 17
@@ -15,14 +18,129 @@
 #define EXIT_BTN_PIN 14
 
 GyverOLED<SSD1306_128x64, OLED_BUFFER> oled;
-GButton upBtn(UP_BTN_PIN);
-GButton downBtn(DOWN_BTN_PIN);
-GButton rightBtn(RIGHT_BTN_PIN);
-GButton leftBtn(LEFT_BTN_PIN);
-GButton selectBtn(SELECT_BTN_PIN);
-GButton exitBtn(EXIT_BTN_PIN);
-
-GTimer gameTimer(MS, 20);
+
+// --- Ввод: прерывания GPIO, очередь событий и автоповтор ---
+// Фронты ловятся в прерывании с меткой micros() и складываются в кольцевую очередь
+// (пишет только ISR, читает только loop()), поэтому короткое нажатие во время
+// delay() или долгого кадра не теряется. Антидребезг тоже в ISR: фронт принимается,
+// только если уровень сменился и с прошлого принятого фронта прошло INPUT_DEBOUNCE_US.
+#define INPUT_DEBOUNCE_US 8000
+#define INPUT_HOLD_MS 500      // нажатие дольше - удержание, клик при отпускании не засчитывается
+#define INPUT_QUEUE_SIZE 32    // степень двойки
+
+// Автоповтор: срабатывание сразу при нажатии, затем через delayMs, дальше интервал
+// уменьшается на accelMs с каждым повтором от startMs до minMs
+struct KeyRepeat { uint16_t delayMs, startMs, minMs, accelMs; };
+
+struct InputEvent { uint32_t us; uint8_t key; bool pressed; };
+
+struct InputState {
+  InputEvent queue[INPUT_QUEUE_SIZE];
+  volatile uint8_t head = 0, tail = 0;
+  volatile uint32_t dropped = 0;
+  uint32_t lastLatencyUs = 0, maxLatencyUs = 0; // от фронта до обработчика
+};
+InputState inputState;
+portMUX_TYPE inputMux = portMUX_INITIALIZER_UNLOCKED;
+
+inline void inputNoteLatency(uint32_t eventUs) {
+  inputState.lastLatencyUs = micros() - eventUs;
+  if (inputState.lastLatencyUs > inputState.maxLatencyUs) inputState.maxLatencyUs = inputState.lastLatencyUs;
+}
+
+// Кнопка на подтяжке к питанию. isClick() и автоповтор - одноразовые флаги, живут
+// один проход loop() после события, isHold() - текущее состояние после антидребезга
+class InputButton {
+ public:
+  explicit InputButton(uint8_t pin) : pin(pin) {}
+  bool isClick() {
+    if (!clicked) return false;
+    clicked = false; inputNoteLatency(releaseUs); return true;
+  }
+  bool isHold() const { return pressed; }
+  // Погасить клик и нажатие этого прохода, не засчитывая их
+  void consume() { clicked = false; pressLatched = false; }
+  bool isRepeat(const KeyRepeat& cfg) {
+    uint32_t now = millis();
+    if (pressLatched) {
+      pressLatched = false; repeatAtMs = now + cfg.delayMs; repeatInterval = cfg.startMs;
+      inputNoteLatency(pressUs); return true;
+    }
+    if (!pressed || (int32_t)(now - repeatAtMs) < 0) return false;
+    repeatAtMs = now + repeatInterval;
+    repeatInterval = repeatInterval > cfg.minMs + cfg.accelMs ? repeatInterval - cfg.accelMs : cfg.minMs;
+    return true;
+  }
+
+  const uint8_t pin;
+  volatile bool isrPressed = false;  // принятое в ISR состояние
+  volatile uint32_t isrEdgeUs = 0;
+  bool pressed = false, clicked = false, pressLatched = false;
+  uint32_t pressUs = 0, releaseUs = 0, repeatAtMs = 0;
+  uint16_t repeatInterval = 0;
+};
+
+InputButton upBtn(UP_BTN_PIN);
+InputButton downBtn(DOWN_BTN_PIN);
+InputButton rightBtn(RIGHT_BTN_PIN);
+InputButton leftBtn(LEFT_BTN_PIN);
+InputButton selectBtn(SELECT_BTN_PIN);
+InputButton exitBtn(EXIT_BTN_PIN);
+// DRAM_ATTR: таблицу читает ISR, а константа без него легла бы во флеш (.rodata)
+InputButton* const inputButtons[] DRAM_ATTR = { &upBtn, &downBtn, &rightBtn, &leftBtn, &selectBtn, &exitBtn };
+const uint8_t INPUT_BUTTONS = sizeof(inputButtons) / sizeof(inputButtons[0]);
+
+// Вызывается под inputMux. GPIO_IN_REG вместо digitalRead: ISR должен работать
+// из IRAM и во время записи во флеш (LittleFS), когда кэш флеша отключён
+void IRAM_ATTR inputPushEdge(uint8_t key, uint32_t now) {
+  InputButton& b = *inputButtons[key];
+  bool pressed = !(REG_READ(GPIO_IN_REG) & (1UL << b.pin));
+  if (pressed == b.isrPressed || now - b.isrEdgeUs < INPUT_DEBOUNCE_US) return;
+  uint8_t next = (inputState.head + 1) & (INPUT_QUEUE_SIZE - 1);
+  if (next == inputState.tail) { inputState.dropped++; return; }
+  b.isrPressed = pressed; b.isrEdgeUs = now;
+  inputState.queue[inputState.head] = { now, key, pressed };
+  inputState.head = next;
+}
+
+void IRAM_ATTR inputIsr(void* arg) {
+  portENTER_CRITICAL_ISR(&inputMux);
+  inputPushEdge((uint8_t)(uintptr_t)arg, micros());
+  portEXIT_CRITICAL_ISR(&inputMux);
+}
+
+void inputBegin() {
+  for (uint8_t i = 0; i < INPUT_BUTTONS; i++) {
+    pinMode(inputButtons[i]->pin, INPUT_PULLUP);
+    inputButtons[i]->isrPressed = inputButtons[i]->pressed = !digitalRead(inputButtons[i]->pin);
+    attachInterruptArg(inputButtons[i]->pin, inputIsr, (void*)(uintptr_t)i, CHANGE);
+  }
+}
+
+// Раз за проход loop(): сбрасывает одноразовые флаги прошлого прохода и применяет
+// накопленные события. Если последний фронт дребезга был отброшен и уровень так и
+// остался другим, он досылается отсюда, чтобы кнопка не "залипала"
+void inputPoll() {
+  uint32_t now = micros();
+  for (uint8_t i = 0; i < INPUT_BUTTONS; i++) {
+    InputButton& b = *inputButtons[i];
+    b.consume();
+    portENTER_CRITICAL(&inputMux);
+    if (now - b.isrEdgeUs >= INPUT_DEBOUNCE_US) inputPushEdge(i, now);
+    portEXIT_CRITICAL(&inputMux);
+  }
+  while (inputState.tail != inputState.head) {
+    const InputEvent& e = inputState.queue[inputState.tail];
+    InputButton& b = *inputButtons[e.key];
+    if (e.pressed) { b.pressed = true; b.pressLatched = true; b.pressUs = e.us; }
+    else {
+      if (b.pressed && e.us - b.pressUs < INPUT_HOLD_MS * 1000UL) b.clicked = true;
+      b.pressed = false; b.releaseUs = e.us;
+    }
+    inputState.tail = (inputState.tail + 1) & (INPUT_QUEUE_SIZE - 1);
+  }
+}
+
 WebServer server(80);
 
 enum SystemState {
@@ -41,16 +159,17 @@ enum SystemState {
   TEMP_CONVERTER,
   COUNTER,
   TEXT_EDITOR,
-  GAME_PONG,
-  GAME_ASTEROIDS,
-  GAME_FLAPPY_BIRD,
   GAME_TETRIS,
-  GAME_DINO,
   GAME_SNAKE,
+  GAME_FLAPPY_BIRD,
   GAME_ARKANOID,
+  GAME_DINO,
+  GAME_ASTEROIDS,
+  GAME_PONG,
   GAME_DICE,
   MULTIPLICATION_TABLE,
-  READER_APP
+  READER_APP,
+  SYSTEM_STATE_COUNT
 };
 
 SystemState currentState = BOOT;
@@ -63,8 +182,6 @@ struct MenuState {
     int maxPages = 1;
 };
 
-File uploadFile;
-File readerFile; 
 
 MenuState mainMenuState;
 MenuState settingsMenuState;
@@ -72,38 +189,406 @@ MenuState miniAppsMenuState;
 MenuState appsMenuState;
 MenuState gamesMenuState;
 
+// --- Описания меню: пункты и состояние связаны один раз, без поиска по заголовку ---
+struct MenuDescriptor {
+    const char* title;
+    const char* const* items;
+    uint8_t itemCount;
+    uint8_t itemsPerPage;
+    MenuState* state;
+};
+
+const char* const mainMenuItems[] = {"Выключение", "Перезагрузка", "Мини приложения", "Настройки"};
+const char* const settingsItems[] = {"Калибровка", "О системе", "Назад"};
+const char* const miniAppsItems[] = {"Игры", "Приложения", "Назад"};
+
+const MenuDescriptor mainMenu = {"Меню", mainMenuItems, 4, 4, &mainMenuState};
+const MenuDescriptor settingsMenu = {"Настройки", settingsItems, 3, 3, &settingsMenuState};
+const MenuDescriptor miniAppsMenu = {"Мини приложения", miniAppsItems, 3, 3, &miniAppsMenuState};
+
+// Экран нужно перерисовать целиком: сменилось состояние или поверх меню было сообщение
+bool screenDirty = true;
+
 bool wifiAPMode = false;
 
+// --- Веб-сервер в отдельной задаче ---
+// server.handleClient() крутится на ядре 0, loop() с играми на ядре 1 его больше не ждет.
+// Обработчики маршрутов сообщают интерфейсу о переменах через очередь webState.events,
+// а любой доступ к LittleFS с обеих сторон идет под fsMutex (FsLock).
+#define WEB_TASK_CORE 0
+#define WEB_TASK_PRIORITY 1   // ниже задачи дисплея: передача кадра важнее загрузки файла
+#define WEB_TASK_STACK 8192
+#define WEB_EVENT_QUEUE_LEN 8
+
+enum WebEvent : uint8_t { WEB_FILES_CHANGED };
+
+struct WebState {
+  TaskHandle_t task = NULL;
+  QueueHandle_t events = NULL;
+  SemaphoreHandle_t fsMutex = NULL;  // рекурсивный: вложенные функции чтения берут его повторно
+};
+WebState webState;
+
+// Держит fsMutex до конца области видимости
+struct FsLock {
+  FsLock() { if (webState.fsMutex) xSemaphoreTakeRecursive(webState.fsMutex, portMAX_DELAY); }
+  ~FsLock() { if (webState.fsMutex) xSemaphoreGiveRecursive(webState.fsMutex); }
+  FsLock(const FsLock&) = delete;
+  FsLock& operator=(const FsLock&) = delete;
+};
+
+// Из задачи сервера: не блокируется, при полной очереди событие теряется -
+// интерфейс все равно перечитает список при следующем
+inline void webPostEvent(WebEvent event) {
+  if (webState.events) xQueueSend(webState.events, &event, 0);
+}
+
+// --- Загрузка файлов: /upload[?crc32=hex][&sha256=hex] ---
+// Куски от HTTP-парсера (до 1436 байт) копятся в block и уходят в LittleFS целыми
+// блоками флеша. Данные пишутся в <имя>.part и переименовываются только после
+// проверки контрольной суммы, так что оборванная загрузка не портит старый файл.
+#define UPLOAD_BLOCK_SIZE 4096   // размер блока LittleFS на ESP32
+
+struct UploadState {
+  File file;
+  String path, partPath;
+  uint8_t block[UPLOAD_BLOCK_SIZE];
+  size_t blockLen = 0;
+  uint32_t bytes = 0;
+  uint32_t startUs = 0;
+  bool failed = false;
+  bool checkCrc = false, checkSha = false;
+  uint32_t crc = 0, expectedCrc = 0;
+  uint8_t expectedSha[32];
+  mbedtls_sha256_context sha;
+  int status = 200;          // ответ маршрута /upload
+  String result = "OK";
+  bool pending = false;      // файл принят потоком, ответ еще не отправлен
+  uint32_t lastBytesPerSec = 0;
+};
+UploadState uploadState;
+
+// --- Индекс корня LittleFS ---
+// Каталог обходится один раз на всех: читалка, файловый менеджер и /list берут записи
+// по номеру. Загрузка, создание и удаление файлов сбрасывают индекс (webFilesChanged),
+// следующий доступ строит его заново. Читать и строить - только под FsLock.
+#define DIR_INDEX_MAX 256
+#define DIR_NAME_POOL 6144   // имена подряд через '\0'
+
+enum FileType : uint8_t { FILE_OTHER, FILE_TEXT, FILE_IMAGE, FILE_DIR };
+
+struct DirEntry {
+  uint32_t size;
+  uint16_t name;   // смещение в pool
+  FileType type;
+};
+
+struct DirIndex {
+  DirEntry entries[DIR_INDEX_MAX];
+  char pool[DIR_NAME_POOL];
+  uint16_t count = 0, poolUsed = 0;
+  uint16_t reader[DIR_INDEX_MAX];  // номера записей .txt, .tz, .h и .tim - список читалки
+  uint16_t readerCount = 0;
+  bool valid = false;
+  bool truncated = false;          // в индекс поместились не все файлы
+};
+DirIndex dirIndex;
+
+// ext - без точки, регистр не важен
+bool fileHasExtension(const char* name, const char* ext) {
+  const char* dot = strrchr(name, '.');
+  return dot && strcasecmp(dot + 1, ext) == 0;
+}
+
+FileType fileTypeOf(const char* name) {
+  if (fileHasExtension(name, "txt") || fileHasExtension(name, "tz")) return FILE_TEXT;
+  if (fileHasExtension(name, "h") || fileHasExtension(name, "tim")) return FILE_IMAGE;
+  return FILE_OTHER;
+}
+
+void dirIndexBuild() {
+  FsLock lock;
+  DirIndex& d = dirIndex;
+  d.count = d.poolUsed = d.readerCount = 0;
+  d.truncated = false;
+  File root = LittleFS.open("/");
+  for (File file = root.openNextFile(); file; file = root.openNextFile()) {
+    const char* name = file.name();
+    if (*name == '/') name++;
+    if (*name == '.') continue;  // служебные файлы (индексы читалки) не показываем
+    size_t len = strlen(name) + 1;
+    if (d.count == DIR_INDEX_MAX || d.poolUsed + len > DIR_NAME_POOL) { d.truncated = true; break; }
+    DirEntry& e = d.entries[d.count];
+    memcpy(d.pool + d.poolUsed, name, len);
+    e.name = d.poolUsed; d.poolUsed += len;
+    e.type = file.isDirectory() ? FILE_DIR : fileTypeOf(name);
+    e.size = e.type == FILE_DIR ? 0 : file.size();
+    if (e.type == FILE_TEXT || e.type == FILE_IMAGE) d.reader[d.readerCount++] = d.count;
+    d.count++;
+  }
+  d.valid = true;
+}
+
+// Вызывать под FsLock: пока он взят, индекс не перестроится из другой задачи
+DirIndex& dirIndexGet() {
+  if (!dirIndex.valid) dirIndexBuild();
+  return dirIndex;
+}
+
+inline const char* dirEntryName(const DirEntry& e) { return dirIndex.pool + e.name; }
+
+// Служебные файлы читалки рядом с исходным: индекс страниц книги и разобранная картинка
+String readerIndexPath(const String& bookName) { return "/." + bookName + ".idx"; }
+String imageCachePath(const String& imageName) { return "/." + imageName + ".bin"; }
+
+// Из обработчиков маршрутов после любого изменения файлов
+void webFilesChanged() {
+  { FsLock lock; dirIndex.valid = false; }
+  webPostEvent(WEB_FILES_CHANGED);
+}
+
+// --- Вывод на дисплей: двойной буфер, передача по I2C в отдельной задаче ---
+// Буфер GyverOLED хранится по столбцам: страница p столбца x лежит в _oled_buffer[x * 8 + p]
+#define OLED_I2C_ADDR 0x3C
+#define OLED_WIDTH 128
+#define OLED_PAGES 8
+#define OLED_BUF_INDEX(x, page) (((x) << 3) + (page))
+#define OLED_I2C_CHUNK 64      // байт данных в одной I2C транзакции
+#define OLED_WINDOW_COST 10    // служебные байты на одно окно (команды 0x21/0x22 + заголовки)
+
+#define DISPLAY_TASK_CORE 0   // loop() крутится на ядре 1
+#define DISPLAY_TASK_PRIORITY 2
+#define DISPLAY_TASK_STACK 3072
+
+struct OledFlushState {
+  uint8_t front[OLED_WIDTH * OLED_PAGES];  // готовый кадр, который передает задача дисплея
+  uint8_t shadow[OLED_WIDTH * OLED_PAGES]; // то, что сейчас лежит в памяти SSD1306
+  bool shadowValid = false;                // false = следующий кадр уйдет целиком
+  uint16_t lastFrameBytes = 0;             // байт по шине за последний кадр
+  uint8_t lastFrameWindows = 0;
+  uint32_t totalBytes = 0;
+  uint32_t frames = 0;
+  TaskHandle_t task = NULL;
+  SemaphoreHandle_t frontFree = NULL;      // свободен, когда задача закончила передачу front
+  uint32_t lastPresentUs = 0;
+  uint32_t drawUs = 0;                     // логика и отрисовка кадра приложением
+  uint32_t transferUs = 0;                 // передача кадра по I2C
+  uint32_t waitUs = 0;                     // сколько приложение ждало освобождения front
+};
+OledFlushState oledFlushState;
+
+// --- Часы игр: фиксированный шаг симуляции и отдельная частота кадров ---
+// Время копится в accumulator и тратится целыми шагами по tickMs, поэтому скорость игры
+// не зависит от того, сколько занял проход loop(). Кадр рисуется, только если с прошлого
+// кадра что-то изменилось, и не чаще renderMs. При перегрузке несколько шагов идут
+// подряд с одним кадром на всех; больше GAME_MAX_CATCHUP шагов не догоняем.
+#define GAME_TICK_MS 20
+#define GAME_RENDER_MS 20
+#define GAME_MAX_CATCHUP 5
+
+struct GameClock {
+  uint16_t tickMs = GAME_TICK_MS;
+  uint16_t renderMs = GAME_RENDER_MS;
+  uint32_t lastMs = 0;
+  uint32_t accumulator = 0;
+  uint32_t lastRenderMs = 0;
+  bool needRender = true;
+  uint32_t skippedFrames = 0;  // шаги, после которых кадр не рисовался из-за догонки
+};
+GameClock gameClock;
+
+// Вызывается при входе в игру и при рестарте
+void gameClockStart(uint16_t tickMs, uint16_t renderMs = GAME_RENDER_MS) {
+  uint32_t skipped = gameClock.skippedFrames;
+  gameClock = GameClock();
+  gameClock.tickMs = tickMs; gameClock.renderMs = renderMs;
+  gameClock.lastMs = millis(); gameClock.lastRenderMs = gameClock.lastMs - renderMs;
+  gameClock.skippedFrames = skipped;
+}
+// Смена шага на ходу (ускорение змейки, мягкое падение в тетрисе): накопленное время
+// обрезается до одного нового шага, чтобы при переходе на короткий шаг не было рывка
+void gameClockSetTick(uint16_t tickMs) {
+  if (tickMs == gameClock.tickMs) return;
+  gameClock.tickMs = tickMs;
+  gameClock.accumulator = min(gameClock.accumulator, (uint32_t)tickMs);
+}
+// Сколько шагов симуляции выполнить в этом проходе loop()
+int gameClockTicks() {
+  uint32_t now = millis();
+  gameClock.accumulator += now - gameClock.lastMs;
+  gameClock.lastMs = now;
+  int ticks = gameClock.accumulator / gameClock.tickMs;
+  if (ticks > GAME_MAX_CATCHUP) { ticks = GAME_MAX_CATCHUP; gameClock.accumulator = 0; }
+  else gameClock.accumulator -= ticks * gameClock.tickMs;
+  if (ticks > 0) { gameClock.needRender = true; gameClock.skippedFrames += ticks - 1; }
+  return ticks;
+}
+// Состояние изменилось вне шага симуляции (например, поворот фигуры по нажатию)
+void gameClockRequestRender() { gameClock.needRender = true; }
+bool gameClockShouldRender() {
+  uint32_t now = millis();
+  if (!gameClock.needRender || now - gameClock.lastRenderMs < gameClock.renderMs) return false;
+  gameClock.needRender = false;
+  gameClock.lastRenderMs = now;
+  return true;
+}
+
+// --- Физика игр в фиксированной точке: int32 с 8 дробными битами (Q24.8) ---
+// Одинаковый результат на любом запуске и без float в тике. Запас целой части нужен,
+// потому что координаты выходят за 127 (астероиды до 138), а произведения - за 16 бит.
+typedef int32_t fix_t;
+#define FIX_SHIFT 8
+#define FIX_ONE (1 << FIX_SHIFT)
+#define FIX(v) ((fix_t)((v) * FIX_ONE))          // из константы или float
+#define FIX_INT(v) ((int)((v) >> FIX_SHIFT))     // в пиксели, округление вниз
+
+struct FixVec { fix_t x, y; };
+
+// Умножение с округлением к нулю: затухание одинаково для положительных и отрицательных скоростей
+inline fix_t fixMul(fix_t a, fix_t b) { return (fix_t)(((int64_t)a * b) / FIX_ONE); }
+// random(lo, hi) / div без float
+inline fix_t fixRandom(int lo, int hi, int div) { return (fix_t)(random(lo, hi) * FIX_ONE / div); }
+inline void fixIntegrate(FixVec& pos, const FixVec& vel) { pos.x += vel.x; pos.y += vel.y; }
+inline void fixScale(FixVec& v, fix_t k) { v.x = fixMul(v.x, k); v.y = fixMul(v.y, k); }
+// Столкновение кругов по квадрату расстояния, без sqrt
+inline bool fixWithinRadius(const FixVec& a, const FixVec& b, fix_t r) {
+  int64_t dx = a.x - b.x, dy = a.y - b.y;
+  return dx * dx + dy * dy < (int64_t)r * r;
+}
+
+// --- Тригонометрия по таблице: угол в двоичных градусах, 256 = полный оборот ---
+typedef uint8_t angle_t;
+#define ANGLE_FROM_RAD(r) ((angle_t)((r) * 256 / (2 * M_PI) + 0.5))
+
+// sin от 0 до 90 градусов (64 шага) в формате fix_t; остальные четверти - симметрией
+const int16_t SIN_QUARTER[65] PROGMEM = {
+  0,6,13,19,25,31,38,44,50,56,62,68,74,80,86,92,98,104,109,115,121,126,132,137,142,147,152,157,162,167,172,177,
+  181,185,190,194,198,202,206,209,213,216,220,223,226,229,231,234,237,239,241,243,245,247,248,250,251,252,253,254,255,255,256,256,256
+};
+
+inline fix_t fixSin(angle_t a) {
+  uint8_t i = a & 63;
+  if (a & 64) i = 64 - i;
+  fix_t v = (int16_t)pgm_read_word(&SIN_QUARTER[i]);
+  return (a & 128) ? -v : v;
+}
+inline fix_t fixCos(angle_t a) { return fixSin(a + 64); }
+// Вектор длины len по курсу a: 0 - вверх, по часовой стрелке (ось Y экрана смотрит вниз)
+inline FixVec fixHeading(angle_t a, fix_t len) { return {fixMul(len, fixSin(a)), -fixMul(len, fixCos(a))}; }
+
+
+// --- Тайловые карты для игр на сетке ---
+// Игра задает сетку (размер ячейки, начало на экране, набор 1bpp-тайлов) и меняет только ячейки.
+// Изменившиеся ячейки помечаются грязными, и для них заново собираются байты страниц в кэше карты.
+// Каждый кадр кэш целиком кладется в буфер GyverOLED по маске области карты.
+// Тайл t (с 1) в наборе - CellW байт по столбцам, бит 0 - верхняя строка ячейки; 0 - пустая ячейка.
+template <int Cols, int Rows, int CellW, int CellH, int OriginX, int OriginY>
+struct TileMap {
+  static_assert(Cols <= 32 && CellH <= 8, "строка грязных ячеек - uint32_t, тайл - один байт на столбец");
+  static const int COLS = Cols, ROWS = Rows, CELL_W = CellW, CELL_H = CellH, ORIGIN_X = OriginX, ORIGIN_Y = OriginY;
+  static const int PAGE0 = OriginY / 8;
+  static const int PAGES = (OriginY + Rows * CellH - 1) / 8 - PAGE0 + 1;
+  static const int WIDTH = Cols * CellW;
+  const uint8_t* tiles;         // PROGMEM
+  uint8_t cells[Cols * Rows];
+  uint32_t dirtyRows[Rows];     // бит col - ячейку (col, row) нужно пересобрать
+  uint8_t cache[WIDTH * PAGES]; // собранные байты страниц, по столбцам как в буфере дисплея
+  explicit TileMap(const uint8_t* tileset) : tiles(tileset) {
+    memset(cells, 0, sizeof(cells)); memset(dirtyRows, 0, sizeof(dirtyRows)); memset(cache, 0, sizeof(cache));
+  }
+};
+
+template <class Map> uint8_t tileMapGet(const Map& map, int col, int row) { return map.cells[row * Map::COLS + col]; }
+template <class Map> void tileMapSet(Map& map, int col, int row, uint8_t tile) {
+  uint8_t& cell = map.cells[row * Map::COLS + col];
+  if (cell == tile) return;
+  cell = tile;
+  map.dirtyRows[row] |= 1UL << col;
+}
+
+// Байт страницы page в столбце x карты: OR всех ячеек столбца, которые задевают эту страницу
+template <class Map> uint8_t tileMapComposeByte(const Map& map, int x, int page) {
+  int col = x / Map::CELL_W, cx = x % Map::CELL_W;
+  int rowFirst = max(0, page * 8 - Map::ORIGIN_Y) / Map::CELL_H;
+  int rowLast = min(Map::ROWS - 1, (page * 8 + 7 - Map::ORIGIN_Y) / Map::CELL_H);
+  uint8_t out = 0;
+  for (int row = rowFirst; row <= rowLast; row++) {
+    uint8_t tile = map.cells[row * Map::COLS + col];
+    if (!tile) continue;
+    uint8_t bits = pgm_read_byte(map.tiles + (tile - 1) * Map::CELL_W + cx) & ((1 << Map::CELL_H) - 1);
+    int shift = Map::ORIGIN_Y + row * Map::CELL_H - page * 8;
+    out |= shift >= 0 ? bits << shift : bits >> -shift;
+  }
+  return out;
+}
+
+template <class Map> void tileMapRender(Map& map) {
+  for (int row = 0; row < Map::ROWS; row++) {
+    uint32_t dirty = map.dirtyRows[row];
+    map.dirtyRows[row] = 0;
+    int y0 = Map::ORIGIN_Y + row * Map::CELL_H;
+    while (dirty) {
+      int col = __builtin_ctz(dirty);
+      dirty &= dirty - 1;
+      for (int page = y0 / 8; page <= (y0 + Map::CELL_H - 1) / 8; page++) {
+        for (int x = col * Map::CELL_W; x < (col + 1) * Map::CELL_W; x++) {
+          map.cache[x * Map::PAGES + page - Map::PAGE0] = tileMapComposeByte(map, x, page);
+        }
+      }
+    }
+  }
+  int top = Map::ORIGIN_Y, bottom = Map::ORIGIN_Y + Map::ROWS * Map::CELL_H - 1;
+  for (int p = 0; p < Map::PAGES; p++) {
+    int page = Map::PAGE0 + p;
+    uint8_t mask = (0xFF << (max(top, page * 8) - page * 8)) & (0xFF >> (page * 8 + 7 - min(bottom, page * 8 + 7)));
+    for (int x = 0; x < Map::WIDTH; x++) {
+      uint8_t& dst = oled._oled_buffer[OLED_BUF_INDEX(Map::ORIGIN_X + x, page)];
+      dst = (dst & ~mask) | map.cache[x * Map::PAGES + p];
+    }
+  }
+}
 
+const uint8_t TETRIS_TILES[] PROGMEM = { 0x07,0x07,0x07,  0x07,0x05,0x07 };          // блок, тень
+const uint8_t SNAKE_TILES[] PROGMEM = { 0x0F,0x0F,0x0F,0x0F,  0x0F,0x09,0x09,0x0F }; // тело, еда
+const uint8_t ARKANOID_TILES[] PROGMEM = { 0x0F,0x0F,0x0F,0x0F,0x0F,0x0F,0x0F,0x0F,0x0F,0x00,0x00,0x00 }; // кирпич 9x4 с зазором
+#define TILE_BLOCK 1
+#define TILE_GHOST 2
+#define TILE_FOOD 2
 
 
 struct DinoGame {
-  int dinoY = 47; float dinoSpeed = 0; float obstacleX = 128; int score = 0; 
+  int dinoY = 47; fix_t dinoSpeed = 0; fix_t obstacleX = FIX(128); int score = 0; 
   bool gameOver = false; bool jumping = false; bool crouching = false; bool legFlag = true;
-  bool birdFlag = true; int8_t enemyType = 0; float gameSpeed = 1.5; 
-  unsigned long lastScoreUpdate = 0; unsigned long lastEnemyUpdate = 0;
-  unsigned long lastLegUpdate = 0; unsigned long lastBirdUpdate = 0; unsigned long lastDinoUpdate = 0;
+  bool birdFlag = true; int8_t enemyType = 0; fix_t gameSpeed = FIX(1.5); 
+  uint32_t ticks = 0;  // шаги по GAME_TICK_MS: очки, анимация ног и крыльев считаются от них
 };
 
 
+// Змейка - кольцевой буфер клеток поля 32x13 и битовая карта занятости:
+// ход, рост и проверка самопересечения не зависят от длины
 struct SnakeGame {
-  static const int MAX_LENGTH = 80; int snakeX[MAX_LENGTH]; int snakeY[MAX_LENGTH];
-  int snakeLength = 4; int foodX, foodY; int dirX = 1, dirY = 0; int score = 0;
-  bool gameOver = false; int segmentSize = 4; unsigned long lastMoveTime = 0; int moveDelay = 150;
+  static const int COLS = 32; static const int ROWS = 13; static const int TOP = 12;
+  static const int MAX_LENGTH = COLS * ROWS;
+  uint16_t body[MAX_LENGTH]; int head = 0;  // body[head] - клетка головы, хвост на snakeLength - 1 позиций раньше
+  uint32_t occupied[ROWS] = {0};            // бит col строки row - клетка занята телом
+  TileMap<COLS, ROWS, 4, 4, 0, TOP> board{SNAKE_TILES};
+  int snakeLength = 4; int foodCell = 0; int dirX = 1, dirY = 0; int score = 0;
+  bool gameOver = false; int moveDelay = 150;
 };
 
 
 struct TetrisGame {
   static const int FIELD_WIDTH = 10; static const int FIELD_HEIGHT = 16;
-  byte field[FIELD_HEIGHT][FIELD_WIDTH] = {0}; byte currentPieceType; byte nextPieceType;
-  int currentPiece[4][2]; int pieceX = FIELD_WIDTH / 2 - 1; int pieceY = 0;
-  int score = 0; bool gameOver = false; unsigned long lastDropTime = 0; int dropDelay = 500;
+  uint16_t rows[FIELD_HEIGHT]; byte currentPieceType; byte nextPieceType;
+  byte rotation = 0; int pieceX = FIELD_WIDTH / 2 - 1; int pieceY = 0;
+  TileMap<FIELD_WIDTH, FIELD_HEIGHT, 3, 3, 40, 14> board{TETRIS_TILES};
+  int score = 0; bool gameOver = false; int dropDelay = 500;
 };
 
 
 struct ArkanoidGame {
-  int paddleX = 54; int ballX = 64, ballY = 55; float ballVelX = 1.0, ballVelY = 1.0;
-  bool bricks[5][10]; int score = 0; bool gameOver = false; int paddleWidth = 24; int ballSize = 2;
+  int paddleX = 54; FixVec ball = {FIX(64), FIX(55)}; FixVec ballVel = {FIX(1), FIX(1)};
+  TileMap<10, 5, 12, 5, 2, 12> bricks{ARKANOID_TILES}; int score = 0; bool gameOver = false; int paddleWidth = 24; int ballSize = 2;
 };
 
 
@@ -135,24 +620,25 @@ struct TextEditorState {
 
 
 struct PongGame {
-    float paddle1Y = 24; float paddle2Y = 24; float ballX = 64, ballY = 32;
-    float ballVelX = 1.5, ballVelY = 1.0; int score1 = 0, score2 = 0;
+    fix_t paddle1Y = FIX(24); fix_t paddle2Y = FIX(24); FixVec ball = {FIX(64), FIX(32)};
+    FixVec ballVel = {FIX(1.5), FIX(1)}; int score1 = 0, score2 = 0;
     bool gameOver = false; int paddleHeight = 16; int ballSize = 3;
 };
 
 
 struct AsteroidsGame {
-    float shipX = 64, shipY = 50; float shipVelX = 0, shipVelY = 0; float shipAngle = 0;
+    FixVec ship = {FIX(64), FIX(50)}; FixVec shipVel = {0, 0}; angle_t shipAngle = 0;
     bool thrusting = false; bool gameOver = false; int score = 0;
-    static const int MAX_ASTEROIDS = 10; static const int MAX_BULLETS = 5;
-    struct Asteroid { float x, y, velX, velY; int size; bool active; };
-    struct Bullet { float x, y, velX, velY; bool active; };
+    static const int MAX_ASTEROIDS = 16; static const int MAX_BULLETS = 8;
+    static const angle_t TURN_STEP = ANGLE_FROM_RAD(0.1); static const angle_t WING_ANGLE = ANGLE_FROM_RAD(2.5);
+    struct Asteroid { FixVec pos, vel; int size; bool active; };
+    struct Bullet { FixVec pos, vel; bool active; };
     Asteroid asteroids[MAX_ASTEROIDS]; Bullet bullets[MAX_BULLETS];
 };
 
 
 struct FlappyBirdGame {
-    float birdY = 32; float birdVel = 0; static const int MAX_PIPES = 5;
+    fix_t birdY = FIX(32); fix_t birdVel = 0; static const int MAX_PIPES = 5;
     struct Pipe { int x; int gapY; bool passed; };
     Pipe pipes[MAX_PIPES]; int score = 0; bool gameOver = false;
     unsigned long lastPipeTime = 0; int pipeSpacing = 50;
@@ -167,32 +653,167 @@ struct WifiScannerState {
 struct MultiplicationTableApp { int multiplier1 = 1; int multiplier2 = 1; };
 
 // --- Структура для Читалки ---
+#define READER_SLIDE_MS 1000   // начальный интервал слайд-шоу картинок
+
+// Экраны открытой книги
+enum ReaderView : uint8_t { READER_VIEW_PAGE, READER_VIEW_MENU, READER_VIEW_JUMP, READER_VIEW_QUERY, READER_VIEW_SEARCH };
+
 struct ReaderAppState {
     int cursor = 0;
     int filesCount = 0;
-    static const int MAX_PAGE_HISTORY = 150;
-    long pageHistory[MAX_PAGE_HISTORY] = {0};
-    int currentHistoryIndex = -1;
-    int totalPages = 0;
+    // Индекс страниц книги: смещение каждой stride-й страницы. Когда таблица заполнена,
+    // каждая вторая запись выбрасывается и stride удваивается: память постоянна,
+    // а до любой страницы не больше stride-1 страниц пересчета
+    static const uint16_t MAX_CHECKPOINTS = 1024;
+    uint32_t checkpoints[MAX_CHECKPOINTS];
+    uint16_t checkpointCount = 0;
+    uint16_t stride = 1;
+    uint32_t totalPages = 0;       // размечено страниц
+    uint32_t scanPos = 0;          // начало первой неразмеченной страницы
+    bool indexComplete = false;
+    bool indexDirty = false;       // индекс изменился с последнего сохранения
+    uint32_t page = 0, pagePos = 0;
+    bool pagePending = false;      // открыто по смещению совпадения дальше разметки: номер страницы
+                                   // появится, когда фоновая разметка дойдет до pagePos
+    uint32_t savedPage = 0;        // страница, записанная в файл индекса
+    String bookName;
+    uint32_t fileSize = 0, fileTime = 0;
+    ReaderView view = READER_VIEW_PAGE;
+    uint8_t menuCursor = 0;
+    uint32_t jumpTarget = 0;
+    bool slideshow = false;
+    uint32_t slideMs = READER_SLIDE_MS, slideAtMs = 0;
     bool inFileReader = false; // Флаг, что мы внутри просмотра файла
 };
 
-DinoGame dino;
-SnakeGame snake;
-TetrisGame tetris;
-StopwatchApp stopwatch;
-ArkanoidGame arkanoid;
-CounterApp counterApp;
-TimerAppState timerApp;
-DrawAppState drawApp;
-TempConverterState tempConverter;
-TextEditorState textEditor;
-PongGame pong;
-AsteroidsGame asteroids;
-FlappyBirdGame flappyBird;
-WifiScannerState wifiScanner;
-MultiplicationTableApp multiplicationTable;
-ReaderAppState readerApp;
+// --- Структура для поиска по книге ---
+#define SEARCH_QUERY_CHARS 16
+#define SEARCH_MAX_HITS 256
+#define SEARCH_BUF 1024
+
+struct ReaderSearch {
+    uint8_t query[SEARCH_QUERY_CHARS];        // номера символов алфавита ввода
+    uint8_t queryLen = 0;
+    uint8_t pattern[SEARCH_QUERY_CHARS * 2 + 1];  // запрос в UTF-8, нижний регистр
+    uint8_t patternLen = 0;
+    uint8_t skip[256];                        // сдвиги Бойера-Мура-Хорспула
+    uint8_t buf[SEARCH_BUF];
+    uint16_t bufLen = 0;                      // хвост прошлого куска в начале buf
+    uint32_t bufBase = 0;                     // смещение buf[0] в тексте
+    uint32_t readPos = 0;
+    uint32_t hits[SEARCH_MAX_HITS];           // первые совпадения по порядку
+    uint16_t hitCount = 0, hit = 0;
+    uint32_t totalHits = 0;
+    bool hitMode = false;                     // <> на странице листают совпадения
+    uint8_t shownPercent = 0;
+    uint32_t startMs = 0;
+    uint32_t doneMs = 0;                      // поиск окончен, на экране итог; 0 - идет
+    uint32_t kbps = 0;
+};
+
+#define READER_BLOCK 256
+#define TZ_BLOCK_MAX 4096     // наибольший блок сжатого текста .tz
+
+// Распакованный блок .tz
+struct TextBlock {
+  uint8_t data[TZ_BLOCK_MAX];
+  uint32_t start = 0;
+  uint16_t len = 0;
+};
+
+// Чтение файла блоками с произвольным доступом по смещению
+struct TextCursor {
+  File file;
+  uint32_t size = 0;           // длина текста (для .tz - исходного)
+  uint32_t rawSize = 0;        // длина файла на флеше
+  uint8_t buf[READER_BLOCK];
+  uint32_t bufStart = 0;
+  uint16_t bufLen = 0;
+  bool packed = false;
+  uint16_t blockSize = 0;
+  TextBlock* block = NULL;     // есть только у курсоров читалки
+};
+
+// Проигрыватель .tim (формат - в разделе "Картинки .tim")
+struct TimPlayer {
+  TextCursor src;
+  uint8_t width = 0, pages = 0, x0 = 0, page0 = 0;
+  uint16_t frames = 0, frameMs = 0, frame = 0;
+  uint32_t firstFrame = 0, pos = 0;
+  uint32_t nextFrameMs = 0;
+  uint32_t decodeUs = 0;      // последний кадр
+};
+
+// Все состояние читалки: книга, поиск, буферы чтения и проигрыватель картинок
+struct ReaderAppArena {
+  ReaderAppState app;
+  ReaderSearch search;
+  TextBlock textBlock, scanBlock;
+  TextCursor text;   // отрисовка страниц
+  TextCursor scan;   // фоновая разметка и поиск: свой буфер, чтобы не сбивать отрисовку
+  TimPlayer tim;
+};
+
+// --- Арена состояний приложений ---
+// Активно только одно приложение, поэтому их состояния делят одну область appArena:
+// при входе в приложение его состояние конструируется на месте прежнего, при выходе
+// разрушается (это делает loop() по реестру приложений). Арена размером с самое
+// большое состояние (читалка); остальное раньше занимало ОЗУ постоянно.
+// Старые имена (dino, snake, readerApp...) - ссылки в арену: трогать их можно,
+// только пока открыто это приложение.
+union AppArena {
+  AppArena() {}
+  ~AppArena() {}
+  DinoGame dino;
+  SnakeGame snake;
+  TetrisGame tetris;
+  ArkanoidGame arkanoid;
+  PongGame pong;
+  AsteroidsGame asteroids;
+  FlappyBirdGame flappyBird;
+  StopwatchApp stopwatch;
+  CounterApp counter;
+  TimerAppState timer;
+  DrawAppState draw;
+  TempConverterState tempConverter;
+  TextEditorState textEditor;
+  WifiScannerState wifiScanner;
+  MultiplicationTableApp multiplicationTable;
+  ReaderAppArena reader;
+};
+AppArena appArena;
+
+DinoGame& dino = appArena.dino;
+SnakeGame& snake = appArena.snake;
+TetrisGame& tetris = appArena.tetris;
+StopwatchApp& stopwatch = appArena.stopwatch;
+ArkanoidGame& arkanoid = appArena.arkanoid;
+CounterApp& counterApp = appArena.counter;
+TimerAppState& timerApp = appArena.timer;
+DrawAppState& drawApp = appArena.draw;
+TempConverterState& tempConverter = appArena.tempConverter;
+TextEditorState& textEditor = appArena.textEditor;
+PongGame& pong = appArena.pong;
+AsteroidsGame& asteroids = appArena.asteroids;
+FlappyBirdGame& flappyBird = appArena.flappyBird;
+WifiScannerState& wifiScanner = appArena.wifiScanner;
+MultiplicationTableApp& multiplicationTable = appArena.multiplicationTable;
+ReaderAppState& readerApp = appArena.reader.app;
+ReaderSearch& readerSearch = appArena.reader.search;
+TextBlock& readerTextBlock = appArena.reader.textBlock;
+TextBlock& readerScanBlock = appArena.reader.scanBlock;
+TextCursor& readerText = appArena.reader.text;
+TextCursor& readerScan = appArena.reader.scan;
+TimPlayer& timPlayer = appArena.reader.tim;
+
+// Конструирование и разрушение члена арены; адреса этих функций лежат в реестре приложений
+template <class T, T AppArena::*member> void appArenaConstruct() { new (&(appArena.*member)) T(); }
+template <class T, T AppArena::*member> void appArenaDestroy() { (appArena.*member).~T(); }
+
+// Список файлов листается быстро и разгоняется, страницы текста - медленнее
+const KeyRepeat READER_LIST_REPEAT = { 300, 150, 40, 10 };
+const KeyRepeat READER_PAGE_REPEAT = { 500, 350, 150, 50 };
+const KeyRepeat READER_JUMP_REPEAT = { 400, 120, 20, 10 };
 
 // --- Битмапы для Динозавра ---
 const uint8_t DinoStandL_bmp[] PROGMEM = { 0xC0,0x00,0x00,0x00,0x00,0x80,0x80,0xC0,0xFE,0xFF,0xFD,0xBF,0xAF,0x2F,0x2F,0x0E,0x03,0x07,0x1E,0x1E,0xFF,0xBF,0x1F,0x3F,0x7F,0x4F,0x07,0x00,0x01,0x00,0x00,0x00, };
@@ -206,16 +827,56 @@ const uint8_t BirdL_bmp[] PROGMEM = { 0x30,0x38,0x3C,0x3C,0x3F,0x3F,0x7F,0x7C,0x
 const uint8_t BirdR_bmp[] PROGMEM = { 0x00,0x80,0xC0,0xE0,0xF0,0xF0,0xF0,0xC0,0x0F,0xFE,0xF8,0xF8,0xF0,0xE0,0xC0,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0x03,0x03,0x03,0x03,0x03,0x07,0x0E,0x1F,0x7F,0x7F,0xFF,0xFF,0xFF,0xFF,0xFC,0xFC,0xF8,0xF8,0x78,0x68,0x68,0x68, };
 
 // --- Фигуры для Тетриса ---
-const byte PIECES[7][4][2] = {
+constexpr byte PIECES[7][4][2] = {
   {{0, 1}, {1, 1}, {2, 1}, {3, 1}}, {{1, 0}, {1, 1}, {1, 2}, {2, 2}}, {{2, 0}, {2, 1}, {2, 2}, {1, 2}},
   {{1, 1}, {2, 1}, {2, 0}, {3, 0}}, {{1, 0}, {2, 0}, {2, 1}, {3, 1}}, {{1, 1}, {0, 1}, {2, 1}, {1, 2}},
   {{1, 1}, {2, 1}, {1, 2}, {2, 2}}
 };
 
+// Строка поля Тетриса - uint16_t: столбец x лежит в бите x + TETRIS_WALL, а биты за краями поля
+// всегда заняты (стенки). Поэтому столкновение - это сдвиг маски фигуры и AND без проверки границ.
+#define TETRIS_WALL 3
+#define TETRIS_EMPTY_ROW ((uint16_t)~(0x3FF << TETRIS_WALL))
+#define TETRIS_FULL_ROW 0xFFFF
+
+// Фигура в одном повороте: rows[i] - клетки строки dy + i, бит 0 соответствует столбцу dx
+struct TetrisShape { uint8_t rows[4]; int8_t dx, dy; };
+
+// Повороты считаются при компиляции из PIECES тем же правилом, что и раньше:
+// на 90 градусов вокруг клетки 1, которая при повороте остается на месте.
+constexpr int tetrisRotY(int t, int i, int r);
+constexpr int tetrisRotX(int t, int i, int r) {
+  return r == 0 ? PIECES[t][i][0] : PIECES[t][1][0] - (tetrisRotY(t, i, r - 1) - PIECES[t][1][1]);
+}
+constexpr int tetrisRotY(int t, int i, int r) {
+  return r == 0 ? PIECES[t][i][1] : PIECES[t][1][1] + (tetrisRotX(t, i, r - 1) - PIECES[t][1][0]);
+}
+constexpr int tetrisMin(int a, int b) { return a < b ? a : b; }
+constexpr int tetrisMinX(int t, int r) {
+  return tetrisMin(tetrisMin(tetrisRotX(t, 0, r), tetrisRotX(t, 1, r)), tetrisMin(tetrisRotX(t, 2, r), tetrisRotX(t, 3, r)));
+}
+constexpr int tetrisMinY(int t, int r) {
+  return tetrisMin(tetrisMin(tetrisRotY(t, 0, r), tetrisRotY(t, 1, r)), tetrisMin(tetrisRotY(t, 2, r), tetrisRotY(t, 3, r)));
+}
+constexpr uint8_t tetrisCellBit(int t, int i, int r, int row) {
+  return tetrisRotY(t, i, r) - tetrisMinY(t, r) == row ? 1 << (tetrisRotX(t, i, r) - tetrisMinX(t, r)) : 0;
+}
+constexpr uint8_t tetrisRowMask(int t, int r, int row) {
+  return tetrisCellBit(t, 0, r, row) | tetrisCellBit(t, 1, r, row) | tetrisCellBit(t, 2, r, row) | tetrisCellBit(t, 3, r, row);
+}
+#define TETRIS_ROTATION(t, r) { { tetrisRowMask(t, r, 0), tetrisRowMask(t, r, 1), tetrisRowMask(t, r, 2), tetrisRowMask(t, r, 3) }, \
+                                tetrisMinX(t, r), tetrisMinY(t, r) }
+#define TETRIS_PIECE(t) { TETRIS_ROTATION(t, 0), TETRIS_ROTATION(t, 1), TETRIS_ROTATION(t, 2), TETRIS_ROTATION(t, 3) }
+constexpr TetrisShape TETRIS_SHAPES[7][4] = {
+  TETRIS_PIECE(0), TETRIS_PIECE(1), TETRIS_PIECE(2), TETRIS_PIECE(3), TETRIS_PIECE(4), TETRIS_PIECE(5), TETRIS_PIECE(6)
+};
+
 // Объявления функций
 void showBootScreen();
 void handleReaderApp();
 void initReaderApp();
+bool imageCacheBuild(const String& name);
+void webPollEvents();
 void handleMainMenu();
 void handleSettings();
 void handleSystemInfo();
@@ -241,47 +902,219 @@ void handleDiceGame();
 void handleMultiplicationTable();
 void handleRoot();
 void handleFileCreate();
+void handleFileList();
 void handleFileUpload();
-void drawMenu(const char* title, const char* items[], int itemCount, int currentPage, int totalPages);
+void drawMenu(const MenuDescriptor& menu);
 void showMessage(const char* message);
 void tetrisNewPiece();
 bool tetrisCheckCollision(int x, int y);
+void drawSystemInfo();
+void drawStopwatch();
+void exitWifiScanner();
+void exitReaderApp();
+void initDrawApp();
+void initTetrisGame();
+void initSnakeGame();
+void initFlappyBirdGame();
+void initArkanoidGame();
+void initDinoGame();
+void initAsteroidsGame();
+void initPongGame();
+
+// --- Реестр приложений ---
+// По записи на каждое SystemState в порядке перечисления (проверяется при компиляции).
+// loop() вызывает хуки записи текущего состояния, меню "Приложения" и "Игры" собираются
+// из записей своей категории в том же порядке. При смене currentState: onExit старого,
+// разрушение его состояния в арене, конструирование нового, onEnter.
+// Новое приложение: значение в SystemState, запись здесь и, если нужна память, член AppArena.
+enum AppCategory : uint8_t { APP_CATEGORY_SYSTEM, APP_CATEGORY_APPS, APP_CATEGORY_GAMES };
+
+struct AppDescriptor {
+  SystemState state;
+  const char* name;
+  AppCategory category;
+  void (*onEnter)();    // состояние в арене уже сконструировано, может вернуть в меню
+  void (*onTick)();     // ввод и логика; рисует сам, если нет onRender
+  void (*onRender)();
+  void (*onExit)();     // перед разрушением состояния: файлы, сканирование WiFi
+  uint16_t tickMs;      // 0 - каждый проход loop()
+  uint16_t footprint;   // байт в арене
+  void (*construct)();
+  void (*destroy)();
+};
+
+#define APP_NO_STATE 0, NULL, NULL
+#define APP_STATE(T, member) sizeof(T), appArenaConstruct<T, &AppArena::member>, appArenaDestroy<T, &AppArena::member>
+
+constexpr AppDescriptor APP_REGISTRY[] = {
+  { BOOT, "", APP_CATEGORY_SYSTEM, NULL, NULL, NULL, NULL, 0, APP_NO_STATE },
+  { MAIN_MENU, "Меню", APP_CATEGORY_SYSTEM, NULL, handleMainMenu, NULL, NULL, 0, APP_NO_STATE },
+  { SETTINGS, "Настройки", APP_CATEGORY_SYSTEM, NULL, handleSettings, NULL, NULL, 0, APP_NO_STATE },
+  { SYSTEM_INFO, "О системе", APP_CATEGORY_SYSTEM, NULL, handleSystemInfo, drawSystemInfo, NULL, 0, APP_NO_STATE },
+  { MINI_APPS, "Мини приложения", APP_CATEGORY_SYSTEM, NULL, handleMiniApps, NULL, NULL, 0, APP_NO_STATE },
+  { APPS, "Приложения", APP_CATEGORY_SYSTEM, NULL, handleApps, NULL, NULL, 0, APP_NO_STATE },
+  { GAMES, "Игры", APP_CATEGORY_SYSTEM, NULL, handleGames, NULL, NULL, 0, APP_NO_STATE },
+  { STOPWATCH, "Секундомер", APP_CATEGORY_APPS, NULL, handleStopwatch, drawStopwatch, NULL, 30, APP_STATE(StopwatchApp, stopwatch) },
+  { WIFI_SCANNER, "Сканер WiFi", APP_CATEGORY_APPS, NULL, handleWifiScanner, NULL, exitWifiScanner, 0, APP_STATE(WifiScannerState, wifiScanner) },
+  { TIMER_APP, "Таймер", APP_CATEGORY_APPS, NULL, handleTimerApp, NULL, NULL, 0, APP_STATE(TimerAppState, timer) },
+  { FILE_MANAGER, "Файловый менеджер", APP_CATEGORY_APPS, NULL, handleFileManager, NULL, NULL, 0, APP_NO_STATE },
+  { DRAW_APP, "Рисовалка", APP_CATEGORY_APPS, initDrawApp, handleDrawApp, NULL, NULL, 0, APP_STATE(DrawAppState, draw) },
+  { TEMP_CONVERTER, "Конвертер темп", APP_CATEGORY_APPS, NULL, handleTempConverter, NULL, NULL, 0, APP_STATE(TempConverterState, tempConverter) },
+  { COUNTER, "Счетчик", APP_CATEGORY_APPS, NULL, handleCounter, NULL, NULL, 0, APP_STATE(CounterApp, counter) },
+  { TEXT_EDITOR, "Текстовый редактор", APP_CATEGORY_APPS, NULL, handleTextEditor, NULL, NULL, 0, APP_STATE(TextEditorState, textEditor) },
+  { GAME_TETRIS, "Тетрис", APP_CATEGORY_GAMES, initTetrisGame, handleTetrisGame, NULL, NULL, 0, APP_STATE(TetrisGame, tetris) },
+  { GAME_SNAKE, "Змейка", APP_CATEGORY_GAMES, initSnakeGame, handleSnakeGame, NULL, NULL, 0, APP_STATE(SnakeGame, snake) },
+  { GAME_FLAPPY_BIRD, "Flappy Bird", APP_CATEGORY_GAMES, initFlappyBirdGame, handleFlappyBirdGame, NULL, NULL, 0, APP_STATE(FlappyBirdGame, flappyBird) },
+  { GAME_ARKANOID, "Арканоид", APP_CATEGORY_GAMES, initArkanoidGame, handleArkanoidGame, NULL, NULL, 0, APP_STATE(ArkanoidGame, arkanoid) },
+  { GAME_DINO, "Ардуино дино", APP_CATEGORY_GAMES, initDinoGame, handleDinoGame, NULL, NULL, 0, APP_STATE(DinoGame, dino) },
+  { GAME_ASTEROIDS, "Астероид", APP_CATEGORY_GAMES, initAsteroidsGame, handleAsteroidsGame, NULL, NULL, 0, APP_STATE(AsteroidsGame, asteroids) },
+  { GAME_PONG, "Понг", APP_CATEGORY_GAMES, initPongGame, handlePongGame, NULL, NULL, 0, APP_STATE(PongGame, pong) },
+  { GAME_DICE, "Кубик", APP_CATEGORY_GAMES, NULL, handleDiceGame, NULL, NULL, 0, APP_NO_STATE },
+  { MULTIPLICATION_TABLE, "Таблица умножения", APP_CATEGORY_APPS, NULL, handleMultiplicationTable, NULL, NULL, 0, APP_STATE(MultiplicationTableApp, multiplicationTable) },
+  { READER_APP, "Читалка", APP_CATEGORY_APPS, initReaderApp, handleReaderApp, NULL, exitReaderApp, 0, APP_STATE(ReaderAppArena, reader) },
+};
+
+constexpr bool appRegistryOrdered(int i) {
+  return i == SYSTEM_STATE_COUNT || (APP_REGISTRY[i].state == i && appRegistryOrdered(i + 1));
+}
+static_assert(sizeof(APP_REGISTRY) / sizeof(APP_REGISTRY[0]) == SYSTEM_STATE_COUNT && appRegistryOrdered(0),
+              "APP_REGISTRY: по одной записи на SystemState в порядке перечисления");
+
+constexpr uint8_t appCategorySize(AppCategory category, int i) {
+  return i == SYSTEM_STATE_COUNT ? 0 : (APP_REGISTRY[i].category == category) + appCategorySize(category, i + 1);
+}
+
+// Меню приложений и игр: записи категории по порядку реестра и "Назад" последним пунктом
+#define APPS_MENU_ITEMS (appCategorySize(APP_CATEGORY_APPS, 0) + 1)
+#define GAMES_MENU_ITEMS (appCategorySize(APP_CATEGORY_GAMES, 0) + 1)
+const char* appsItems[APPS_MENU_ITEMS];
+const char* gamesItems[GAMES_MENU_ITEMS];
+SystemState appsTargets[APPS_MENU_ITEMS - 1];
+SystemState gamesTargets[GAMES_MENU_ITEMS - 1];
+const MenuDescriptor appsMenu = {"Приложения", appsItems, APPS_MENU_ITEMS, 5, &appsMenuState};
+const MenuDescriptor gamesMenu = {"Игры", gamesItems, GAMES_MENU_ITEMS, 5, &gamesMenuState};
+
+void appMenuBuild(AppCategory category, const char** items, SystemState* targets) {
+  uint8_t n = 0;
+  for (int state = 0; state < SYSTEM_STATE_COUNT; state++) {
+    if (APP_REGISTRY[state].category != category) continue;
+    items[n] = APP_REGISTRY[state].name;
+    targets[n++] = (SystemState)state;
+  }
+  items[n] = "Назад";
+}
+
+// Смена приложения; onEnter может сразу вернуть в меню - это разберет следующий проход loop()
+void appSwitch(SystemState from, SystemState to) {
+  const AppDescriptor& prev = APP_REGISTRY[from];
+  const AppDescriptor& next = APP_REGISTRY[to];
+  screenDirty = true;
+  if (prev.onExit) prev.onExit();
+  if (prev.destroy) prev.destroy();
+  if (next.construct) next.construct();
+  if (next.onEnter) next.onEnter();
+}
+
+// Сколько байт состояний приложений больше не занято постоянно
+size_t appArenaSaved() {
+  size_t total = 0;
+  for (int state = 0; state < SYSTEM_STATE_COUNT; state++) total += APP_REGISTRY[state].footprint;
+  return total - sizeof(AppArena);
+}
 
 
+// --- Функции для Змейки ---
+int snakeTailIndex() { return (snake.head - snake.snakeLength + 1 + SnakeGame::MAX_LENGTH) % SnakeGame::MAX_LENGTH; }
+bool snakeOccupied(int cell) { return snake.occupied[cell / SnakeGame::COLS] & (1UL << (cell % SnakeGame::COLS)); }
+void snakePushHead(int cell) {
+    snake.head = (snake.head + 1) % SnakeGame::MAX_LENGTH;
+    snake.body[snake.head] = cell;
+    snake.occupied[cell / SnakeGame::COLS] |= 1UL << (cell % SnakeGame::COLS);
+    tileMapSet(snake.board, cell % SnakeGame::COLS, cell / SnakeGame::COLS, TILE_BLOCK);
+    snake.snakeLength++;
+}
+void snakePopTail() {
+    int cell = snake.body[snakeTailIndex()];
+    snake.occupied[cell / SnakeGame::COLS] &= ~(1UL << (cell % SnakeGame::COLS));
+    tileMapSet(snake.board, cell % SnakeGame::COLS, cell / SnakeGame::COLS, 0);
+    snake.snakeLength--;
+}
+// Еда ставится только в свободную клетку: выбирается k-я свободная по popcount строк.
+// Возвращает false, если свободных клеток не осталось.
+bool snakePlaceFood() {
+    int freeCells = SnakeGame::MAX_LENGTH - snake.snakeLength;
+    if (freeCells <= 0) return false;
+    int k = random(freeCells);
+    for (int row = 0; row < SnakeGame::ROWS; row++) {
+        uint32_t freeMask = ~snake.occupied[row];
+        int n = __builtin_popcount(freeMask);
+        if (k >= n) { k -= n; continue; }
+        while (k--) freeMask &= freeMask - 1;  // снимаем младшие свободные биты
+        snake.foodCell = row * SnakeGame::COLS + __builtin_ctz(freeMask);
+        tileMapSet(snake.board, __builtin_ctz(freeMask), row, TILE_FOOD);
+        return true;
+    }
+    return false;
+}
+
+// Один ход змейки на клетку (шаг часов = moveDelay)
+void snakeStep() {
+    int headCell = snake.body[snake.head];
+    int col = headCell % SnakeGame::COLS + snake.dirX;
+    int row = headCell / SnakeGame::COLS + snake.dirY;
+    if (col < 0 || col >= SnakeGame::COLS || row < 0 || row >= SnakeGame::ROWS) { snake.gameOver = true; return; }
+    int newCell = row * SnakeGame::COLS + col;
+    bool ate = newCell == snake.foodCell;
+    if (!ate) snakePopTail();  // хвост уходит раньше, чем голова занимает клетку
+    if (snakeOccupied(newCell)) { snake.gameOver = true; return; }
+    snakePushHead(newCell);
+    if (ate) {
+      snake.score += 10;
+      snake.moveDelay = max(80, snake.moveDelay - 3); 
+      if (!snakePlaceFood()) { snake.gameOver = true; return; }  // поле заполнено целиком
+    }
+}
+
 // ---- Функции инициализации игр и приложений ----
 void initDinoGame() {
     dino = DinoGame();
     dino.enemyType = random(0, 3);
-    dino.lastScoreUpdate = millis();
+    gameClockStart(GAME_TICK_MS);
 }
 void initSnakeGame() {
     snake = SnakeGame();
-    for (int i = 0; i < snake.snakeLength; i++) { snake.snakeX[i] = 64 - i * 4; snake.snakeY[i] = 32; }
-    snake.foodX = random(0, 32) * 4; snake.foodY = random(3, 16) * 4;
+    snake.snakeLength = 0;
+    for (int i = 3; i >= 0; i--) snakePushHead(5 * SnakeGame::COLS + 16 - i);
+    snakePlaceFood();
+    gameClockStart(snake.moveDelay);
 }
 void initTetrisGame() {
     tetris = TetrisGame();
     tetris.nextPieceType = random(7);
-    for (int y = 0; y < tetris.FIELD_HEIGHT; y++) { for (int x = 0; x < tetris.FIELD_WIDTH; x++) tetris.field[y][x] = 0; }
+    for (int y = 0; y < tetris.FIELD_HEIGHT; y++) tetris.rows[y] = TETRIS_EMPTY_ROW;
     tetrisNewPiece();
+    gameClockStart(tetris.dropDelay);
 }
 void initArkanoidGame() {
     arkanoid = ArkanoidGame();
-    for (int y = 0; y < 5; y++) { for (int x = 0; x < 10; x++) arkanoid.bricks[y][x] = true; }
+    for (int y = 0; y < 5; y++) { for (int x = 0; x < 10; x++) tileMapSet(arkanoid.bricks, x, y, TILE_BLOCK); }
+    gameClockStart(GAME_TICK_MS);
 }
 void initPongGame() {
     pong = PongGame();
-    pong.ballVelY = random(-10, 11) / 10.0;
+    pong.ballVel.y = fixRandom(-10, 11, 10);
+    gameClockStart(GAME_TICK_MS);
 }
 void initAsteroidsGame() {
     asteroids = AsteroidsGame();
     for (int i = 0; i < asteroids.MAX_ASTEROIDS; i++) asteroids.asteroids[i].active = false;
     for (int i = 0; i < asteroids.MAX_BULLETS; i++) asteroids.bullets[i].active = false;
     for (int i = 0; i < 3; i++) {
-        asteroids.asteroids[i].active = true; asteroids.asteroids[i].x = random(0, 128);
-        asteroids.asteroids[i].y = random(0, 20); asteroids.asteroids[i].velX = random(-10, 11) / 10.0;
-        asteroids.asteroids[i].velY = random(1, 10) / 10.0; asteroids.asteroids[i].size = 2;
+        asteroids.asteroids[i].active = true; asteroids.asteroids[i].pos.x = FIX(random(0, 128));
+        asteroids.asteroids[i].pos.y = FIX(random(0, 20)); asteroids.asteroids[i].vel.x = fixRandom(-10, 11, 10);
+        asteroids.asteroids[i].vel.y = fixRandom(1, 10, 10); asteroids.asteroids[i].size = 2;
     }
+    gameClockStart(GAME_TICK_MS);
 }
 void initFlappyBirdGame() {
     flappyBird = FlappyBirdGame();
@@ -290,68 +1123,78 @@ void initFlappyBirdGame() {
         flappyBird.pipes[i].gapY = random(20, 44);
         flappyBird.pipes[i].passed = false;
     }
+    gameClockStart(GAME_TICK_MS);
 }
-void initStopwatch() { stopwatch = StopwatchApp(); }
-void initTimerApp() { timerApp = TimerAppState(); }
-void initDrawApp() { drawApp = DrawAppState(); oled.clear(); }
-void initTempConverter() { tempConverter = TempConverterState(); }
-void initCounter() { counterApp = CounterApp(); }
-void initTextEditor() { textEditor = TextEditorState(); }
-void initMultiplicationTable() { multiplicationTable = MultiplicationTableApp(); }
+void initDrawApp() { oled.clear(); }
 
 
 // --- Функции для Тетриса ---
-void tetrisRotatePiece() {
-    int tempPiece[4][2];
-    for (int i = 0; i < 4; i++) { tempPiece[i][0] = tetris.currentPiece[i][0]; tempPiece[i][1] = tetris.currentPiece[i][1]; }
-    int pivotX = tempPiece[1][0]; int pivotY = tempPiece[1][1];
-    for (int i = 0; i < 4; i++) {
-        int newX = pivotX - (tempPiece[i][1] - pivotY); int newY = pivotY + (tempPiece[i][0] - pivotX);
-        tempPiece[i][0] = newX; tempPiece[i][1] = newY;
-    }
-    int tempX = tetris.pieceX; int tempY = tetris.pieceY; bool collision = false;
-    for (int i = 0; i < 4; i++) {
-        int px = tempPiece[i][0] + tempX; int py = tempPiece[i][1] + tempY;
-        if (px < 0 || px >= tetris.FIELD_WIDTH || py >= tetris.FIELD_HEIGHT || (py >= 0 && tetris.field[py][px])) { collision = true; break; }
-    }
-    if (!collision) { for (int i = 0; i < 4; i++) { tetris.currentPiece[i][0] = tempPiece[i][0]; tetris.currentPiece[i][1] = tempPiece[i][1]; } }
+const TetrisShape& tetrisShape(byte rotation) { return TETRIS_SHAPES[tetris.currentPieceType][rotation]; }
+// Выше поля - пустые строки со стенками, ниже дна - сплошные
+uint16_t tetrisRowAt(int y) {
+    if (y >= tetris.FIELD_HEIGHT) return TETRIS_FULL_ROW;
+    return y < 0 ? TETRIS_EMPTY_ROW : tetris.rows[y];
 }
-bool tetrisCheckCollision(int x, int y) {
+bool tetrisCollides(byte rotation, int x, int y) {
+    const TetrisShape& shape = tetrisShape(rotation);
+    int shift = x + shape.dx + TETRIS_WALL;
+    if (shift < 0) return true;
     for (int i = 0; i < 4; i++) {
-        int px = tetris.currentPiece[i][0] + x; int py = tetris.currentPiece[i][1] + y;
-        if (px < 0 || px >= tetris.FIELD_WIDTH || py >= tetris.FIELD_HEIGHT) return true;
-        if (py >= 0 && tetris.field[py][px]) return true;
+        if (shape.rows[i] && (tetrisRowAt(y + shape.dy + i) & ((uint16_t)shape.rows[i] << shift))) return true;
     }
     return false;
 }
+void tetrisRotatePiece() {
+    byte next = (tetris.rotation + 1) & 3;
+    if (!tetrisCollides(next, tetris.pieceX, tetris.pieceY)) tetris.rotation = next;
+}
+bool tetrisCheckCollision(int x, int y) { return tetrisCollides(tetris.rotation, x, y); }
+// На сколько строк фигура может упасть: не больше высоты поля, по 4 AND на шаг
+int tetrisDropDistance() {
+    int d = 0;
+    while (!tetrisCheckCollision(tetris.pieceX, tetris.pieceY + d + 1)) d++;
+    return d;
+}
 void tetrisPlacePiece() {
+    const TetrisShape& shape = tetrisShape(tetris.rotation);
+    int shift = tetris.pieceX + shape.dx + TETRIS_WALL;
     for (int i = 0; i < 4; i++) {
-        int px = tetris.currentPiece[i][0] + tetris.pieceX; int py = tetris.currentPiece[i][1] + tetris.pieceY;
-        if (py >= 0) { tetris.field[py][px] = tetris.currentPieceType + 1; }
+        int y = tetris.pieceY + shape.dy + i;
+        if (y >= 0 && y < tetris.FIELD_HEIGHT) tetris.rows[y] |= (uint16_t)shape.rows[i] << shift;
     }
 }
+// Один проход снизу вверх: заполненные строки пропускаются, остальные сдвигаются на их место
 void tetrisClearLines() {
+    int dst = tetris.FIELD_HEIGHT - 1;
     for (int y = tetris.FIELD_HEIGHT - 1; y >= 0; y--) {
-        bool lineFull = true;
-        for (int x = 0; x < tetris.FIELD_WIDTH; x++) { if (tetris.field[y][x] == 0) { lineFull = false; break; } }
-        if (lineFull) {
-            for (int yy = y; yy > 0; yy--) { for (int x = 0; x < tetris.FIELD_WIDTH; x++) { tetris.field[yy][x] = tetris.field[yy-1][x]; } }
-            for (int x = 0; x < tetris.FIELD_WIDTH; x++) { tetris.field[0][x] = 0; }
-            tetris.score += 100; y++;
-        }
+        if (tetris.rows[y] == TETRIS_FULL_ROW) { tetris.score += 100; continue; }
+        tetris.rows[dst--] = tetris.rows[y];
     }
+    while (dst >= 0) tetris.rows[dst--] = TETRIS_EMPTY_ROW;
 }
 void tetrisNewPiece() {
     tetris.currentPieceType = tetris.nextPieceType; tetris.nextPieceType = random(7);
-    for (int i = 0; i < 4; i++) { tetris.currentPiece[i][0] = PIECES[tetris.currentPieceType][i][0]; tetris.currentPiece[i][1] = PIECES[tetris.currentPieceType][i][1]; }
+    tetris.rotation = 0;
     tetris.pieceX = tetris.FIELD_WIDTH / 2 - 2; tetris.pieceY = 0;
     if (tetrisCheckCollision(tetris.pieceX, tetris.pieceY)) { tetris.gameOver = true; }
 }
+void tetrisLockPiece() {
+    tetrisPlacePiece();
+    tetrisClearLines();
+    tetrisNewPiece();
+}
 
 // --- Функции управления состоянием меню ---
 void resetMenuState(MenuState& state) { state.index = 0; state.page = 0; state.maxItems = 0; state.maxPages = 1; }
 int calculateMenuPages(int itemCount, int itemsPerPage) { return (itemCount + itemsPerPage - 1) / itemsPerPage; }
-void handleMenuNavigation(MenuState& state, int itemCount, int itemsPerPage) {
+int menuSelectedItem(const MenuDescriptor& menu) { return menu.state->page * menu.itemsPerPage + menu.state->index; }
+// Возвращает true, если курсор или страница изменились и меню нужно перерисовать
+bool handleMenuNavigation(const MenuDescriptor& menu) {
+  MenuState& state = *menu.state;
+  int itemCount = menu.itemCount;
+  int itemsPerPage = menu.itemsPerPage;
+  int oldIndex = state.index, oldPage = state.page;
+  state.maxItems = itemCount;
   state.maxPages = calculateMenuPages(itemCount, itemsPerPage);
   if (upBtn.isClick()) {
     state.index--;
@@ -376,205 +1219,465 @@ void handleMenuNavigation(MenuState& state, int itemCount, int itemsPerPage) {
   }
   if (leftBtn.isClick() && state.maxPages > 1) { state.page = (state.page - 1 + state.maxPages) % state.maxPages; state.index = 0; }
   if (rightBtn.isClick() && state.maxPages > 1) { state.page = (state.page + 1) % state.maxPages; state.index = 0; }
+  return state.index != oldIndex || state.page != oldPage;
+}
+
+// --- Вывод кадра на дисплей ---
+// Отправляет в SSD1306 столбцы x0..x1 одной страницы из front и запоминает их в теневой копии
+uint16_t oledSendWindow(uint8_t page, uint8_t x0, uint8_t x1) {
+  uint16_t sent = 0;
+  Wire.beginTransmission(OLED_I2C_ADDR);
+  Wire.write(0x00);                                   // поток команд
+  Wire.write(0x21); Wire.write(x0); Wire.write(x1);   // диапазон столбцов
+  Wire.write(0x22); Wire.write(page); Wire.write(page); // диапазон страниц
+  Wire.endTransmission();
+  sent += 7;
+  for (int x = x0; x <= x1; ) {
+    int chunkEnd = min((int)x1, x + OLED_I2C_CHUNK - 1);
+    Wire.beginTransmission(OLED_I2C_ADDR);
+    Wire.write(0x40);                                 // поток данных
+    sent++;
+    for (; x <= chunkEnd; x++) {
+      uint8_t data = oledFlushState.front[OLED_BUF_INDEX(x, page)];
+      Wire.write(data);
+      oledFlushState.shadow[OLED_BUF_INDEX(x, page)] = data;
+      sent++;
+    }
+    Wire.endTransmission();
+  }
+  return sent;
+}
+
+// Сравнивает front с тем, что уже на экране, и шлет только измененные участки.
+// Близкие участки одной страницы склеиваются, если разрыв дешевле нового окна.
+void oledTransferFrame() {
+  uint16_t sent = 0;
+  uint8_t windows = 0;
+  for (uint8_t page = 0; page < OLED_PAGES; page++) {
+    int runStart = -1, runEnd = -1;
+    for (int x = 0; x < OLED_WIDTH; x++) {
+      int i = OLED_BUF_INDEX(x, page);
+      if (oledFlushState.shadowValid && oledFlushState.front[i] == oledFlushState.shadow[i]) continue;
+      if (runStart >= 0 && x - runEnd > OLED_WINDOW_COST) {
+        sent += oledSendWindow(page, runStart, runEnd); windows++;
+        runStart = -1;
+      }
+      if (runStart < 0) runStart = x;
+      runEnd = x;
+    }
+    if (runStart >= 0) { sent += oledSendWindow(page, runStart, runEnd); windows++; }
+  }
+  oledFlushState.shadowValid = true;
+  oledFlushState.lastFrameBytes = sent;
+  oledFlushState.lastFrameWindows = windows;
+  oledFlushState.totalBytes += sent;
+  oledFlushState.frames++;
+}
+
+void displayTask(void*) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    uint32_t start = micros();
+    oledTransferFrame();
+    oledFlushState.transferUs = micros() - start;
+    xSemaphoreGive(oledFlushState.frontFree);
+  }
+}
+
+void webTask(void*) {
+  for (;;) {
+    server.handleClient();
+    vTaskDelay(1);
+  }
+}
+
+void startWebTask() {
+  webState.events = xQueueCreate(WEB_EVENT_QUEUE_LEN, sizeof(WebEvent));
+  xTaskCreatePinnedToCore(webTask, "web", WEB_TASK_STACK, NULL, WEB_TASK_PRIORITY, &webState.task, WEB_TASK_CORE);
+}
+
+// Вызывается после oled.init(): дальше шиной I2C владеет только задача дисплея
+void startDisplayTask() {
+  oledFlushState.frontFree = xSemaphoreCreateBinary();
+  xSemaphoreGive(oledFlushState.frontFree);
+  xTaskCreatePinnedToCore(displayTask, "display", DISPLAY_TASK_STACK, NULL, DISPLAY_TASK_PRIORITY, &oledFlushState.task, DISPLAY_TASK_CORE);
+  oledFlushState.lastPresentUs = micros();
+}
+
+// Замена oled.update(): копирует нарисованный кадр (буфер GyverOLED) во front и сразу возвращается,
+// пока задача дисплея передает его. Ждет только если предыдущий кадр еще не ушел.
+void oledFlush() {
+  uint32_t now = micros();
+  if (!oledFlushState.task) {
+    memcpy(oledFlushState.front, oled._oled_buffer, sizeof(oledFlushState.front));
+    oledTransferFrame();
+    return;
+  }
+  oledFlushState.drawUs = now - oledFlushState.lastPresentUs;
+  xSemaphoreTake(oledFlushState.frontFree, portMAX_DELAY);
+  uint32_t ready = micros();
+  oledFlushState.waitUs = ready - now;
+  memcpy(oledFlushState.front, oled._oled_buffer, sizeof(oledFlushState.front));
+  xTaskNotifyGive(oledFlushState.task);
+  oledFlushState.lastPresentUs = micros();
+}
+
+// --- Спрайты: PROGMEM-битмапы пишутся прямо в страницы буфера GyverOLED ---
+// Формат как у drawBitmap: (h + 7) / 8 строк по w байт, бит 0 - верхний пиксель.
+// Сдвиг на y % 8 делается над целым байтом столбца: младшая часть ложится в свою страницу,
+// старшая - в следующую. Столбцы за краями экрана отсекаются заранее.
+// mask (необязательно) того же формата: ее единицы сначала гасят фон под непрозрачной частью спрайта.
+void spriteBlit(int x, int y, const uint8_t* bmp, uint8_t w, uint8_t h, const uint8_t* mask = NULL) {
+  int shift = y & 7;
+  int page0 = y >> 3;   // сдвиг округляет вниз и для отрицательных y
+  int c0 = max(0, -x), c1 = min((int)w, OLED_WIDTH - x);
+  for (int p = 0; p < (h + 7) >> 3; p++) {
+    int lo = page0 + p, hi = lo + 1;
+    bool drawLo = lo >= 0 && lo < OLED_PAGES;
+    bool drawHi = shift && hi >= 0 && hi < OLED_PAGES;
+    if (!drawLo && !drawHi) continue;
+    for (int c = c0; c < c1; c++) {
+      uint8_t* column = oled._oled_buffer + OLED_BUF_INDEX(x + c, 0);
+      uint16_t bits = pgm_read_byte(bmp + p * w + c) << shift;
+      if (mask) {
+        uint16_t m = pgm_read_byte(mask + p * w + c) << shift;
+        if (drawLo) column[lo] &= ~m;
+        if (drawHi) column[hi] &= ~(m >> 8);
+      }
+      if (drawLo) column[lo] |= bits;
+      if (drawHi) column[hi] |= bits >> 8;
+    }
+  }
+}
+
+#ifdef SPRITE_BENCHMARK
+// Сравнение с oled.drawBitmap на одном и том же наборе позиций, результат в Serial
+void spriteBenchmark() {
+  const int N = 500;
+  uint32_t start = micros();
+  for (int i = 0; i < N; i++) oled.drawBitmap(i % 120 - 8, i % 56, BirdL_bmp, 24, 16);
+  uint32_t bitmapUs = micros() - start;
+  oled.clear();
+  start = micros();
+  for (int i = 0; i < N; i++) spriteBlit(i % 120 - 8, i % 56, BirdL_bmp, 24, 16);
+  uint32_t blitUs = micros() - start;
+  oled.clear();
+  Serial.printf("Sprite 24x16 x%d: drawBitmap %lu us, spriteBlit %lu us\n", N, (unsigned long)bitmapUs, (unsigned long)blitUs);
 }
+#endif
 
 void setup() {
   Serial.begin(115200);
+  Serial.printf("App arena: %u B, %u B of app state not resident, heap %lu B\n",
+                (unsigned)sizeof(AppArena), (unsigned)appArenaSaved(), (unsigned long)ESP.getFreeHeap());
   randomSeed(analogRead(0));
-  upBtn.setType(HIGH_PULL); downBtn.setType(HIGH_PULL); rightBtn.setType(HIGH_PULL);
-  leftBtn.setType(HIGH_PULL); selectBtn.setType(HIGH_PULL); exitBtn.setType(HIGH_PULL);
+  inputBegin();
   Wire.begin(21, 23);
   oled.init();
   oled.clear();
+#ifdef SPRITE_BENCHMARK
+  spriteBenchmark();
+#endif
+  startDisplayTask();
+  webState.fsMutex = xSemaphoreCreateRecursiveMutex();
   if (!LittleFS.begin(true)) {
     Serial.println("LittleFS Mount Failed");
     showMessage("LittleFS Ошибка!");
     delay(2000);
   }
 
-  mainMenuState.maxItems = 4;
-  settingsMenuState.maxItems = 3;
-  miniAppsMenuState.maxItems = 3;
-  appsMenuState.maxItems = 11;
-  appsMenuState.maxPages = 3;
-  gamesMenuState.maxItems = 9;
-  gamesMenuState.maxPages = 2;
-
   showBootScreen();
   delay(2000);
   WiFi.softAP("TemaOs", "Temaos123");
+  const char* webHeaders[] = { "If-None-Match" };
+  server.collectHeaders(webHeaders, 1);
   server.on("/", handleRoot);
-  server.on("/upload", HTTP_POST, []() { server.send(200, "text/plain", "OK"); }, handleFileUpload);
-  server.on("/create", HTTP_POST, handleFileCreate);
+  server.on("/upload", HTTP_POST, []() {
+    uploadState.pending = false;
+    server.send(uploadState.status, "text/plain", uploadState.result);
+  }, handleFileUpload);
+  server.on("/create", HTTP_POST, handleFileCreate, handleFileUpload);
   server.on("/delete", HTTP_POST, []() {
     if (server.hasArg("filename")) {
       String filename = server.arg("filename");
+      FsLock lock;
       if (LittleFS.exists("/" + filename)) {
-        if (LittleFS.remove("/" + filename)) { server.send(200, "text/plain", "File deleted"); } 
+        if (LittleFS.remove("/" + filename)) {
+          if (LittleFS.exists(readerIndexPath(filename))) LittleFS.remove(readerIndexPath(filename));
+          if (LittleFS.exists(imageCachePath(filename))) LittleFS.remove(imageCachePath(filename));
+          webFilesChanged(); server.send(200, "text/plain", "File deleted");
+        } 
         else { server.send(500, "text/plain", "Failed to delete"); }
       } else { server.send(404, "text/plain", "File not found"); }
     } else { server.send(400, "text/plain", "Missing filename"); }
   });
-  server.on("/list", HTTP_GET, [](){
-      String json = "[";
-      File root = LittleFS.open("/");
-      File file = root.openNextFile();
-      bool first = true;
-      while(file){
-        if(!first){ json += ","; }
-        json += "{\"name\":\"" + String(file.name()).substring(1) + "\",\"size\":" + file.size() + "}";
-        file = root.openNextFile();
-        first = false;
-      }
-      json += "]";
-      server.send(200, "application/json", json);
-    });
+  server.on("/list", HTTP_GET, handleFileList);
   server.begin();
+  startWebTask();
   wifiAPMode = true;
+  appMenuBuild(APP_CATEGORY_APPS, appsItems, appsTargets);
+  appMenuBuild(APP_CATEGORY_GAMES, gamesItems, gamesTargets);
   currentState = MAIN_MENU;
   resetMenuState(mainMenuState);
 }
 
+// Хуки текущего приложения из реестра; при tickMs ввод тоже разбирается раз в tickMs,
+// чтобы одноразовые флаги кнопок дожили до onTick (события ждут в очереди)
 void loop() {
-  upBtn.tick(); downBtn.tick(); rightBtn.tick(); leftBtn.tick(); selectBtn.tick(); exitBtn.tick();
-  server.handleClient();
-  switch (currentState) {
-    case BOOT: break;
-    case MAIN_MENU: handleMainMenu(); break;
-    case SETTINGS: handleSettings(); break;
-    case SYSTEM_INFO: handleSystemInfo(); break;
-    case MINI_APPS: handleMiniApps(); break;
-    case APPS: handleApps(); break;
-    case GAMES: handleGames(); break;
-    case STOPWATCH: handleStopwatch(); break;
-    case WIFI_SCANNER: handleWifiScanner(); break;
-    case TIMER_APP: handleTimerApp(); break;
-    case FILE_MANAGER: handleFileManager(); break;
-    case DRAW_APP: handleDrawApp(); break;
-    case TEMP_CONVERTER: handleTempConverter(); break;
-    case COUNTER: handleCounter(); break;
-    case TEXT_EDITOR: handleTextEditor(); break;
-    case GAME_PONG: handlePongGame(); break;
-    case GAME_ASTEROIDS: handleAsteroidsGame(); break;
-    case GAME_FLAPPY_BIRD: handleFlappyBirdGame(); break;
-    case GAME_TETRIS: handleTetrisGame(); break;
-    case GAME_DINO: handleDinoGame(); break;
-    case GAME_SNAKE: handleSnakeGame(); break;
-    case GAME_ARKANOID: handleArkanoidGame(); break;
-    case GAME_DICE: handleDiceGame(); break;
-    case MULTIPLICATION_TABLE: handleMultiplicationTable(); break;
-    case READER_APP: handleReaderApp(); break;
+  static SystemState lastState = BOOT;
+  static uint32_t lastTickMs = 0;
+  if (currentState != lastState) {
+    SystemState from = lastState;
+    lastState = currentState;
+    appSwitch(from, currentState);
+    return;
   }
+  const AppDescriptor& app = APP_REGISTRY[currentState];
+  if (app.tickMs && millis() - lastTickMs < app.tickMs) return;
+  lastTickMs = millis();
+  inputPoll();
+  webPollEvents();
+  if (app.onTick) app.onTick();
+  if (app.onRender && currentState == app.state) app.onRender();
 }
 
 void showBootScreen() {
   oled.clear(); oled.setCursor(0, 0); oled.setScale(1); oled.print("By Lilux12");
   oled.setCursor(95, 0); oled.print("v3.6R"); oled.setCursor(6, 3); oled.setScale(2);
-  oled.print("Tema OS"); oled.setScale(1); oled.rect(0, 55, 127, 58, OLED_FILL); oled.update();
+  oled.print("Tema OS"); oled.setScale(1); oled.rect(0, 55, 127, 58, OLED_FILL); oledFlush();
 }
 
+// /create: содержимое приходит файловой частью multipart (веб-форма отправляет его как Blob)
+// и идет тем же потоком, что /upload: блоками во временный .part, затем rename.
+// Старый вариант с полем content (urlencoded) тоже принимается, но его тело уже
+// целиком разобрано WebServer в кучу - это только для совместимости.
 void handleFileCreate() {
+  // pending мог остаться от прерванной загрузки (при обрыве этот обработчик не вызывается),
+  // поэтому поле content текущего запроса важнее
+  if (uploadState.pending && !server.hasArg("content")) {
+    uploadState.pending = false;
+    if (uploadState.failed) { server.send(uploadState.status, "text/plain", "Ошибка: " + uploadState.result); return; }
+    server.send(200, "text/plain", "Файл '" + uploadState.path.substring(1) + "' успешно создан!");
+    return;
+  }
+  uploadState.pending = false;
   if (server.hasArg("filename") && server.hasArg("content")) {
     String filename = "/" + server.arg("filename");
-    String content = server.arg("content");
-    if (LittleFS.exists(filename)) { LittleFS.remove(filename); }
-    File file = LittleFS.open(filename, "w");
+    String partPath = filename + ".part";
+    FsLock lock;
+    File file = LittleFS.open(partPath, "w");
     if (!file) { server.send(500, "text/plain", "Ошибка: не удалось создать файл."); return; }
-    size_t bytesWritten = file.print(content);
+    String content = server.arg("content");
+    bool written = file.write((const uint8_t*)content.c_str(), content.length()) == content.length();
     file.close();
-    if (bytesWritten > 0) { server.send(200, "text/plain", "Файл '" + server.arg("filename") + "' успешно создан!"); } 
-    else { server.send(500, "text/plain", "Ошибка: не удалось записать данные."); }
+    if (!written || !LittleFS.rename(partPath, filename)) {
+      LittleFS.remove(partPath);
+      server.send(500, "text/plain", "Ошибка: не удалось записать данные.");
+      return;
+    }
+    if (fileHasExtension(filename.c_str(), "h")) imageCacheBuild(server.arg("filename"));
+    webFilesChanged();
+    server.send(200, "text/plain", "Файл '" + server.arg("filename") + "' успешно создан!");
   } else { server.send(400, "text/plain", "Ошибка: отсутствуют имя файла или его содержимое."); }
 }
 
-void handleRoot() {
-  // ИЗМЕНЕНО: Обновлен HTML для соответствия .h файлам
-  String html = R"rawliteral(
-  <!DOCTYPE html><html><head><meta charset='utf-8'><title>TemaOS File Manager</title>
-  <style>
-    body { font-family: sans-serif; background: #f0f0f0; color: #333; }
-    .container { max-width: 800px; margin: 20px auto; padding: 20px; background: #fff; border-radius: 8px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); }
-    h1, h2 { color: #1a1a1a; }
-    input, textarea, select, button { width: 100%; padding: 10px; margin: 5px 0 15px; border-radius: 4px; border: 1px solid #ccc; box-sizing: border-box; }
-    textarea { height: 150px; resize: vertical; }
-    button { background: #007bff; color: white; border: none; cursor: pointer; font-size: 16px; }
-    button:hover { background: #0056b3; }
-    #fileList { list-style-type: none; padding: 0; }
-    #fileList li { display: flex; justify-content: space-between; align-items: center; padding: 8px; border-bottom: 1px solid #eee; }
-    .delete-btn { background: #dc3545; color: white; border: none; padding: 5px 10px; border-radius: 4px; cursor: pointer; }
-    .delete-btn:hover { background: #c82333; }
-  </style>
-  </head><body><div class='container'>
-  <h1>TemaOS File Manager</h1>
-  <h2>Создать/Загрузить файл</h2>
-  <form id="createForm" action="/create" method="post">
-    <label for="filename">Имя файла (например, test.txt или image.h):</label>
-    <input type="text" id="filename" name="filename" required>
-    <label for="content">Содержимое (для .h вставьте массив байтов как в примере):</label>
-    <textarea id="content" name="content" required></textarea>
-    <button type="submit">Создать Файл</button>
-  </form>
-  <h2>Существующие файлы</h2>
-  <ul id="fileList"></ul>
-  </div>
-  <script>
-    function fetchFiles() {
-      fetch('/list').then(response => response.json()).then(files => {
-        const fileList = document.getElementById('fileList');
-        fileList.innerHTML = '';
-        files.forEach(file => {
-          const li = document.createElement('li');
-          li.textContent = file.name + ' (' + file.size + ' bytes)';
-          const deleteBtn = document.createElement('button');
-          deleteBtn.textContent = 'Удалить';
-          deleteBtn.className = 'delete-btn';
-          deleteBtn.onclick = () => deleteFile(file.name);
-          li.appendChild(deleteBtn);
-          fileList.appendChild(li);
-        });
-      });
-    }
-    function deleteFile(filename) {
-      if (confirm('Вы уверены, что хотите удалить ' + filename + '?')) {
-        const formData = new FormData();
-        formData.append('filename', filename);
-        fetch('/delete', { method: 'POST', body: formData })
-          .then(response => response.text())
-          .then(result => {
-            alert(result);
-            fetchFiles();
-          });
-      }
+// Ответ уходит chunked-кусками по WEB_LIST_CHUNK байт из буфера на стеке
+#define WEB_LIST_CHUNK 256
+
+struct ChunkWriter {
+  char buf[WEB_LIST_CHUNK];
+  size_t len = 0;
+  void flush() { if (len) { server.sendContent(buf, len); len = 0; } }
+  void put(char c) { if (len == sizeof(buf)) flush(); buf[len++] = c; }
+  void print(const char* s) { while (*s) put(*s++); }
+  void print(uint32_t v) { char tmp[11]; snprintf(tmp, sizeof(tmp), "%lu", (unsigned long)v); print(tmp); }
+  // Строка внутри кавычек JSON: экранируем кавычки, обратный слеш и управляющие символы
+  void printJson(const char* s) {
+    for (; *s; s++) {
+      uint8_t c = *s;
+      if (c == '"' || c == '\\') { put('\\'); put(c); }
+      else if (c < 0x20) { char tmp[7]; snprintf(tmp, sizeof(tmp), "\\u%04x", c); print(tmp); }
+      else put(c);
     }
-    document.addEventListener('DOMContentLoaded', fetchFiles);
-  </script>
-  </body></html>
-  )rawliteral";
-  server.send(200, "text/html", html);
+  }
+};
+
+// Курсор /list: сначала записи DirIndex, а если он переполнен - остаток прямо из каталога
+struct FileListCursor {
+  uint16_t next = 0;  // следующая запись индекса
+  File root;          // обход каталога за пределами индекса
+  uint16_t skip = 0;
+  bool done = false;
+};
+
+// Очередная запись для /list. FsLock берется на одну запись, а не на весь ответ: в сеть
+// она уходит уже без него, и медленный клиент не держит файловую систему
+bool fileListNext(FileListCursor& c, char* name, size_t nameSize, uint32_t& size) {
+  if (c.done) return false;
+  FsLock lock;
+  DirIndex& d = dirIndexGet();
+  if (!c.root && c.next < d.count) {
+    const DirEntry& e = d.entries[c.next++];
+    strlcpy(name, dirEntryName(e), nameSize);
+    size = e.size;
+    return true;
+  }
+  if (!d.truncated) { c.done = true; return false; }
+  // Первые d.count записей (в порядке обхода, без служебных) уже отданы из индекса
+  if (!c.root) { c.root = LittleFS.open("/"); c.skip = d.count; }
+  for (File file = c.root.openNextFile(); file; file = c.root.openNextFile()) {
+    const char* fileName = file.name();
+    if (*fileName == '/') fileName++;
+    if (*fileName == '.') continue;
+    if (c.skip) { c.skip--; continue; }
+    strlcpy(name, fileName, nameSize);
+    size = file.isDirectory() ? 0 : file.size();
+    return true;
+  }
+  c.done = true;
+  return false;
+}
+
+// GET /list[?offset=N][&limit=N][&ext=txt] - JSON-массив {name, size}. offset и limit
+// считаются после фильтра по расширению, limit=0 - до конца. Записи берутся из DirIndex,
+// а если он переполнен - остаток идет прямо из каталога, так что отдаются все файлы
+// и память не зависит от их числа.
+void handleFileList() {
+  uint32_t offset = server.hasArg("offset") ? server.arg("offset").toInt() : 0;
+  uint32_t limit = server.hasArg("limit") ? server.arg("limit").toInt() : 0;
+  char ext[12] = "";
+  if (server.hasArg("ext")) {
+    String arg = server.arg("ext");
+    strlcpy(ext, arg.c_str() + (arg.startsWith(".") ? 1 : 0), sizeof(ext));
+  }
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  ChunkWriter out;
+  out.put('[');
+  uint32_t index = 0, sent = 0;
+  FileListCursor cursor;
+  char name[256];  // LFS_NAME_MAX + 1
+  uint32_t size;
+  while ((!limit || sent < limit) && fileListNext(cursor, name, sizeof(name), size)) {
+    if (ext[0] && !fileHasExtension(name, ext)) continue;
+    if (index++ < offset) continue;
+    if (sent++) out.put(',');
+    out.print("{\"name\":\""); out.printJson(name);
+    out.print("\",\"size\":"); out.print(size); out.put('}');
+  }
+  { FsLock lock; cursor.root.close(); }
+  out.put(']');
+  out.flush();
+  server.sendContent("");
+}
+
+// Страница веб-интерфейса: web/index.html, сжатый в include/web_index.h при сборке.
+// Отдается прямо из флеша без копии в куче; повторный заход с тем же ETag получает 304.
+void handleRoot() {
+  server.sendHeader("ETag", WEB_INDEX_ETAG);
+  server.sendHeader("Cache-Control", "no-cache");  // кэшировать, но сверять ETag при каждом заходе
+  if (server.header("If-None-Match") == WEB_INDEX_ETAG) { server.send(304); return; }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, "text/html", (const char*)WEB_INDEX_GZ, WEB_INDEX_GZ_LEN);
+}
+
+bool parseHexBytes(const String& hex, uint8_t* out, size_t len) {
+  if (hex.length() != len * 2) return false;
+  for (size_t i = 0; i < len; i++) {
+    char byteHex[3] = { hex[i * 2], hex[i * 2 + 1], 0 };
+    char* end;
+    out[i] = strtoul(byteHex, &end, 16);
+    if (*end) return false;
+  }
+  return true;
+}
+
+bool uploadFlushBlock() {
+  if (!uploadState.blockLen) return true;
+  FsLock lock;
+  bool ok = uploadState.file.write(uploadState.block, uploadState.blockLen) == uploadState.blockLen;
+  uploadState.blockLen = 0;
+  return ok;
+}
+
+void uploadFail(int status, const char* message) {
+  if (uploadState.checkSha) { mbedtls_sha256_free(&uploadState.sha); uploadState.checkSha = false; }
+  {
+    FsLock lock;
+    if (uploadState.file) uploadState.file.close();
+    LittleFS.remove(uploadState.partPath);
+    dirIndex.valid = false;  // индекс мог перестроиться во время загрузки и запомнить .part
+  }
+  uploadState.failed = true;
+  uploadState.status = status;
+  uploadState.result = message;
+  Serial.printf("Upload %s: %s\n", uploadState.path.c_str(), message);
 }
 
 void handleFileUpload() {
   HTTPUpload& upload = server.upload();
+  UploadState& u = uploadState;
   if (upload.status == UPLOAD_FILE_START) {
-    String filename = "/" + upload.filename;
-    uploadFile = LittleFS.open(filename, "w");
+    u.path = "/" + upload.filename; u.partPath = u.path + ".part";
+    u.blockLen = 0; u.bytes = 0; u.startUs = micros();
+    u.failed = false; u.status = 200; u.result = "OK"; u.pending = true;
+    u.checkCrc = server.hasArg("crc32"); u.crc = 0;
+    if (u.checkCrc) u.expectedCrc = strtoul(server.arg("crc32").c_str(), NULL, 16);
+    u.checkSha = false;
+    if (server.hasArg("sha256")) {
+      if (!parseHexBytes(server.arg("sha256"), u.expectedSha, sizeof(u.expectedSha))) { uploadFail(400, "Неверный sha256"); return; }
+      mbedtls_sha256_init(&u.sha); mbedtls_sha256_starts(&u.sha, 0);
+      u.checkSha = true;
+    }
+    { FsLock lock; u.file = LittleFS.open(u.partPath, "w"); }
+    if (!u.file) uploadFail(500, "Не удалось создать файл");
   } else if (upload.status == UPLOAD_FILE_WRITE) {
-    if (uploadFile) uploadFile.write(upload.buf, upload.currentSize);
+    if (u.failed) return;
+    if (u.checkCrc) u.crc = crc32_le(u.crc, upload.buf, upload.currentSize);
+    if (u.checkSha) mbedtls_sha256_update(&u.sha, upload.buf, upload.currentSize);
+    const uint8_t* src = upload.buf;
+    size_t left = upload.currentSize;
+    while (left) {
+      size_t n = min(left, (size_t)UPLOAD_BLOCK_SIZE - u.blockLen);
+      memcpy(u.block + u.blockLen, src, n);
+      u.blockLen += n; src += n; left -= n;
+      if (u.blockLen == UPLOAD_BLOCK_SIZE && !uploadFlushBlock()) { uploadFail(507, "Нет места"); return; }
+    }
+    u.bytes += upload.currentSize;
   } else if (upload.status == UPLOAD_FILE_END) {
-    if (uploadFile) uploadFile.close();
+    if (u.failed) return;
+    if (!uploadFlushBlock()) { uploadFail(507, "Нет места"); return; }
+    { FsLock lock; u.file.close(); }
+    uint32_t us = max(1UL, (unsigned long)(micros() - u.startUs));
+    if (u.checkCrc && u.crc != u.expectedCrc) { uploadFail(400, "CRC32 не совпадает"); return; }
+    if (u.checkSha) {
+      uint8_t digest[32];
+      mbedtls_sha256_finish(&u.sha, digest); mbedtls_sha256_free(&u.sha); u.checkSha = false;
+      if (memcmp(digest, u.expectedSha, sizeof(digest))) { uploadFail(400, "SHA-256 не совпадает"); return; }
+    }
+    bool renamed;
+    { FsLock lock; renamed = LittleFS.rename(u.partPath, u.path); }
+    if (!renamed) { uploadFail(500, "Не удалось сохранить файл"); return; }
+    if (fileHasExtension(u.path.c_str(), "h")) imageCacheBuild(u.path.substring(1));
+    u.lastBytesPerSec = (uint64_t)u.bytes * 1000000ULL / us;
+    char stats[64];
+    snprintf(stats, sizeof(stats), "OK %lu B, %lu ms, %lu B/s", (unsigned long)u.bytes, (unsigned long)(us / 1000), (unsigned long)u.lastBytesPerSec);
+    u.result = stats;
+    Serial.printf("Upload %s: %s\n", u.path.c_str(), stats);
+    webFilesChanged();
+  } else if (upload.status == UPLOAD_FILE_ABORTED) {
+    uploadFail(400, "Загрузка прервана");
+    u.pending = false;  // ответа не будет: маршрут после обрыва не вызывается
   }
 }
 
 // --- Функции навигации и меню ---
 void handleMainMenu() {
-  const char* mainMenuItems[] = {"Выключение", "Перезагрузка", "Мини приложения", "Настройки"};
-  mainMenuState.maxItems = 4;
-  handleMenuNavigation(mainMenuState, mainMenuState.maxItems, 4);
-  drawMenu("Меню", mainMenuItems, mainMenuState.maxItems, mainMenuState.page, mainMenuState.maxPages);
+  if (handleMenuNavigation(mainMenu) || screenDirty) drawMenu(mainMenu);
   if (selectBtn.isClick()) {
-    switch (mainMenuState.page * 4 + mainMenuState.index) {
-      case 0: oled.clear(); oled.print("Выключение..."); oled.update(); delay(1000); ESP.deepSleep(0); break;
-      case 1: oled.clear(); oled.print("Перезагрузка..."); oled.update(); delay(1000); ESP.restart(); break;
+    switch (menuSelectedItem(mainMenu)) {
+      case 0: oled.clear(); oled.print("Выключение..."); oledFlush(); delay(1000); ESP.deepSleep(0); break;
+      case 1: oled.clear(); oled.print("Перезагрузка..."); oledFlush(); delay(1000); ESP.restart(); break;
       case 2: previousState = currentState; currentState = MINI_APPS; resetMenuState(miniAppsMenuState); break;
       case 3: previousState = currentState; currentState = SETTINGS; resetMenuState(settingsMenuState); break;
     }
@@ -582,12 +1685,9 @@ void handleMainMenu() {
 }
 
 void handleSettings() {
-  const char* settingsItems[] = {"Калибровка", "О системе", "Назад"};
-  settingsMenuState.maxItems = 3;
-  handleMenuNavigation(settingsMenuState, settingsMenuState.maxItems, 3);
-  drawMenu("Настройки", settingsItems, settingsMenuState.maxItems, settingsMenuState.page, settingsMenuState.maxPages);
+  if (handleMenuNavigation(settingsMenu) || screenDirty) drawMenu(settingsMenu);
   if (selectBtn.isClick()) {
-    switch (settingsMenuState.page * 3 + settingsMenuState.index) {
+    switch (menuSelectedItem(settingsMenu)) {
       case 0: showMessage("Калибровка..."); delay(2000); break;
       case 1: previousState = currentState; currentState = SYSTEM_INFO; break;
       case 2: currentState = MAIN_MENU; resetMenuState(mainMenuState); break;
@@ -597,20 +1697,29 @@ void handleSettings() {
 }
 
 void handleSystemInfo() {
-  oled.clear(); oled.setCursor(0, 0); oled.print("О системе"); oled.line(0, 10, 127, 10);
-  oled.setCursor(0, 2); oled.print("TemaOS v3.6R"); oled.setCursor(0, 3); oled.print("By Lilux12");
-  oled.setCursor(0, 4); oled.print("ESP32 Platform"); oled.setCursor(0, 5); oled.print("RAM: "); oled.print(ESP.getFreeHeap());
-  oled.setCursor(0, 7); oled.print("EXIT: назад"); oled.update();
   if (exitBtn.isClick()) { currentState = SETTINGS; resetMenuState(settingsMenuState); }
 }
 
+void drawSystemInfo() {
+  oled.clear(); oled.setCursor(0, 0); oled.print("О системе");
+  oled.setCursor(74, 0); oled.print("ввод "); oled.print(inputState.maxLatencyUs / 1000); oled.print("мс");
+  oled.line(0, 10, 127, 10);
+  oled.setCursor(0, 2); oled.print("TemaOS v3.6R ESP32"); oled.setCursor(0, 3); oled.print("By Lilux12");
+  // после "+" - ОЗУ, которое раньше держали состояния неактивных приложений (арена)
+  oled.setCursor(0, 4); oled.print("RAM: "); oled.print(ESP.getFreeHeap()); oled.print(" +"); oled.print(appArenaSaved()); oled.print(" Б");
+  oled.setCursor(0, 5); oled.print("I2C: ");
+  oled.print(oledFlushState.frames ? oledFlushState.totalBytes / oledFlushState.frames : 0); oled.print(" Б/кадр");
+  oled.setCursor(0, 6); oled.print("Кадр: "); oled.print(oledFlushState.drawUs / 1000);
+  oled.print("/"); oled.print(oledFlushState.transferUs / 1000); oled.print(" мс");
+  // сбои - фронты, не влезшие в очередь ввода
+  oled.setCursor(72, 7); oled.print("сбои "); oled.print(inputState.dropped);
+  oled.setCursor(0, 7); oled.print("EXIT: назад"); oledFlush();
+}
+
 void handleMiniApps() {
-  const char* miniAppsItems[] = {"Игры", "Приложения", "Назад"};
-  miniAppsMenuState.maxItems = 3;
-  handleMenuNavigation(miniAppsMenuState, miniAppsMenuState.maxItems, 3);
-  drawMenu("Мини приложения", miniAppsItems, miniAppsMenuState.maxItems, miniAppsMenuState.page, miniAppsMenuState.maxPages);
+  if (handleMenuNavigation(miniAppsMenu) || screenDirty) drawMenu(miniAppsMenu);
   if (selectBtn.isClick()) {
-    switch (miniAppsMenuState.page * 3 + miniAppsMenuState.index) {
+    switch (menuSelectedItem(miniAppsMenu)) {
       case 0: previousState = currentState; currentState = GAMES; resetMenuState(gamesMenuState); break;
       case 1: previousState = currentState; currentState = APPS; resetMenuState(appsMenuState); break;
       case 2: currentState = MAIN_MENU; resetMenuState(mainMenuState); break;
@@ -619,58 +1728,23 @@ void handleMiniApps() {
   if (exitBtn.isClick()) { currentState = MAIN_MENU; resetMenuState(mainMenuState); }
 }
 
-void handleApps() {
-  const char* appsItems[] = { "Секундомер", "Сканер WiFi", "Таймер", "Файловый менеджер", "Рисовалка", "Конвертер темп", "Счетчик", "Текстовый редактор", "Таблица умножения", "Читалка", "Назад" };
-  appsMenuState.maxItems = 11;
-  int itemsPerPage = 5;
-  handleMenuNavigation(appsMenuState, appsMenuState.maxItems, itemsPerPage);
-  drawMenu("Приложения", appsItems, appsMenuState.maxItems, appsMenuState.page, appsMenuState.maxPages);
+void handleAppMenu(const MenuDescriptor& menu, const SystemState* targets) {
+  if (handleMenuNavigation(menu) || screenDirty) drawMenu(menu);
+  bool back = exitBtn.isClick();
   if (selectBtn.isClick()) {
-    previousState = currentState;
-    switch (appsMenuState.page * itemsPerPage + appsMenuState.index) {
-      case 0: initStopwatch(); currentState = STOPWATCH; break;
-      case 1: currentState = WIFI_SCANNER; break;
-      case 2: initTimerApp(); currentState = TIMER_APP; break;
-      case 3: currentState = FILE_MANAGER; break;
-      case 4: initDrawApp(); currentState = DRAW_APP; break;
-      case 5: initTempConverter(); currentState = TEMP_CONVERTER; break;
-      case 6: initCounter(); currentState = COUNTER; break;
-      case 7: initTextEditor(); currentState = TEXT_EDITOR; break;
-      case 8: initMultiplicationTable(); currentState = MULTIPLICATION_TABLE; break;
-      case 9: initReaderApp(); currentState = READER_APP; break;
-      case 10: currentState = MINI_APPS; resetMenuState(miniAppsMenuState); break;
-    }
-  }
-  if (exitBtn.isClick()) { currentState = MINI_APPS; resetMenuState(miniAppsMenuState); }
-}
-
-void handleGames() {
-  const char* gamesItems[] = { "Тетрис", "Змейка", "Flappy Bird", "Арканоид", "Ардуино дино", "Астероид", "Понг", "Кубик", "Назад" };
-  gamesMenuState.maxItems = 9;
-  handleMenuNavigation(gamesMenuState, gamesMenuState.maxItems, 5);
-  drawMenu("Игры", gamesItems, gamesMenuState.maxItems, gamesMenuState.page, gamesMenuState.maxPages);
-  if (selectBtn.isClick()) {
-    previousState = currentState;
-    switch (gamesMenuState.page * 5 + gamesMenuState.index) {
-      case 0: initTetrisGame(); currentState = GAME_TETRIS; break;
-      case 1: initSnakeGame(); currentState = GAME_SNAKE; break;
-      case 2: initFlappyBirdGame(); currentState = GAME_FLAPPY_BIRD; break;
-      case 3: initArkanoidGame(); currentState = GAME_ARKANOID; break;
-      case 4: initDinoGame(); currentState = GAME_DINO; break;
-      case 5: initAsteroidsGame(); currentState = GAME_ASTEROIDS; break;
-      case 6: initPongGame(); currentState = GAME_PONG; break;
-      case 7: currentState = GAME_DICE; break;
-      case 8: currentState = MINI_APPS; resetMenuState(miniAppsMenuState); break;
-    }
+    int item = menuSelectedItem(menu);
+    if (item < menu.itemCount - 1) { previousState = currentState; currentState = targets[item]; }
+    else back = true;
   }
-  if (exitBtn.isClick()) { currentState = MINI_APPS; resetMenuState(miniAppsMenuState); }
+  if (back) { currentState = MINI_APPS; resetMenuState(miniAppsMenuState); }
 }
 
+void handleApps() { handleAppMenu(appsMenu, appsTargets); }
+void handleGames() { handleAppMenu(gamesMenu, gamesTargets); }
+
 // --- Приложения ---
 void handleStopwatch() {
   if (exitBtn.isClick()) { currentState = previousState; return; }
-  oled.clear();
-  oled.setCursor(0, 0); oled.setScale(1); oled.print("Секундомер"); oled.line(0, 10, 127, 10);
   if (selectBtn.isClick()) {
     if (!stopwatch.running) {
       stopwatch.startTime = millis() - stopwatch.elapsedTime;
@@ -687,6 +1761,11 @@ void handleStopwatch() {
   if (stopwatch.running) {
     stopwatch.elapsedTime = millis() - stopwatch.startTime;
   }
+}
+
+void drawStopwatch() {
+  oled.clear();
+  oled.setCursor(0, 0); oled.setScale(1); oled.print("Секундомер"); oled.line(0, 10, 127, 10);
   int minutes = (stopwatch.elapsedTime / 60000) % 60;
   int seconds = (stopwatch.elapsedTime / 1000) % 60;
   int milliseconds = (stopwatch.elapsedTime % 1000) / 10;
@@ -698,11 +1777,11 @@ void handleStopwatch() {
   oled.setScale(1);
   oled.setCursor(0, 6); oled.print("SELECT: старт/стоп");
   oled.setCursor(0, 7); oled.print("UP: сброс EXIT: выход");
-  oled.update();
+  oledFlush();
 }
 
 void handleWifiScanner() {
-  if (exitBtn.isClick()) { WiFi.scanDelete(); currentState = previousState; return; }
+  if (exitBtn.isClick()) { currentState = previousState; return; }
   oled.clear();
   oled.setCursor(0, 0); oled.setScale(1); oled.print("Сканер WiFi"); oled.line(0, 10, 127, 10);
   int n = WiFi.scanComplete();
@@ -735,7 +1814,7 @@ void handleWifiScanner() {
   }
   oled.setCursor(0, 7); oled.print("SELECT: обновить");
   oled.setCursor(90, 7); oled.print("EXIT");
-  oled.update();
+  oledFlush();
   if (wifiScanner.totalPages > 1) {
       if (leftBtn.isClick()) wifiScanner.currentPage = (wifiScanner.currentPage - 1 + wifiScanner.totalPages) % wifiScanner.totalPages;
       if (rightBtn.isClick()) wifiScanner.currentPage = (wifiScanner.currentPage + 1) % wifiScanner.totalPages;
@@ -743,6 +1822,8 @@ void handleWifiScanner() {
   if (selectBtn.isClick()) { WiFi.scanNetworks(true); }
 }
 
+void exitWifiScanner() { WiFi.scanDelete(); }
+
 void handleTimerApp() {
   if (exitBtn.isClick()) { currentState = previousState; return; }
   oled.clear();
@@ -776,7 +1857,7 @@ void handleTimerApp() {
       oled.setCursor(0, 7); oled.print("UP/DOWN: +/-1 мин");
   }
   oled.setCursor(90, 7); oled.print("EXIT");
-  oled.update();
+  oledFlush();
   if (!timerApp.alarmTriggered) {
       if (selectBtn.isClick()) {
           if (timerApp.running) {
@@ -808,22 +1889,20 @@ void handleFileManager() {
   oled.setCursor(0, 0); oled.setScale(1); oled.print("Файловый менеджер"); oled.line(0, 10, 127, 10);
   oled.setCursor(0, 2); oled.print("Откройте в браузере:");
   oled.setCursor(0, 3); oled.print(WiFi.softAPIP().toString().c_str());
-  oled.setCursor(0, 5); oled.print("Файлы на ESP32:");
-  File root = LittleFS.open("/");
-  File file = root.openNextFile();
-  int y = 6;
-  while (file && y < 8) {
-      oled.setCursor(0, y);
-      String filename = String(file.name());
-      int slashIndex = filename.lastIndexOf('/');
-      String displayName = (slashIndex != -1) ? filename.substring(slashIndex + 1) : filename;
+  if (uploadState.lastBytesPerSec) {
+    oled.setCursor(0, 4); oled.print("Загрузка: "); oled.print(uploadState.lastBytesPerSec / 1024); oled.print(" КБ/с");
+  }
+  FsLock lock;
+  DirIndex& dir = dirIndexGet();
+  oled.setCursor(0, 5); oled.print("Файлы на ESP32: "); oled.print(dir.count); if (dir.truncated) oled.print("+");
+  for (uint16_t i = 0; i < dir.count && i < 2; i++) {
+      oled.setCursor(0, 6 + i);
+      String displayName = dirEntryName(dir.entries[i]);
       if (displayName.length() > 15) displayName = displayName.substring(0, 15) + "..";
       oled.print(displayName.c_str());
-      file = root.openNextFile();
-      y++;
   }
   oled.setCursor(90, 7); oled.print("EXIT");
-  oled.update();
+  oledFlush();
 }
 
 void handleDrawApp() {
@@ -838,7 +1917,7 @@ void handleDrawApp() {
     if (selectBtn.isHold()) {
         oled.line(prevX, prevY, drawApp.cursorX, drawApp.cursorY);
     }
-    oled.update();
+    oledFlush();
     oled.rect(0, 0, 127, 10, OLED_CLEAR);
     oled.setCursor(0, 0); oled.setScale(1); oled.print("Рисовалка");
     char coords[10];
@@ -852,7 +1931,7 @@ void handleDrawApp() {
     } else {
         oled.dot(drawApp.cursorX, drawApp.cursorY);
     }
-    oled.update();
+    oledFlush();
 }
 
 void handleTempConverter() {
@@ -867,7 +1946,7 @@ void handleTempConverter() {
   oled.setCursor(0, 6); oled.print("UP/DOWN: +/-1");
   oled.setCursor(0, 7); oled.print("SELECT: сменить");
   oled.setCursor(90, 7); oled.print("EXIT");
-  oled.update();
+  oledFlush();
   if (tempConverter.convertingCtoF) {
       if (upBtn.isClick()) tempConverter.celsius += 1.0;
       if (downBtn.isClick()) tempConverter.celsius -= 1.0;
@@ -888,7 +1967,7 @@ void handleCounter() {
   oled.setScale(1);
   oled.setCursor(0, 7); oled.print("UP: +1, DOWN: -1");
   oled.setCursor(90, 7); oled.print("EXIT");
-  oled.update();
+  oledFlush();
   if (upBtn.isClick()) counterApp.count++;
   if (downBtn.isClick()) counterApp.count--;
 }
@@ -904,7 +1983,7 @@ void handleTextEditor() {
   oled.print(textEditor.content.substring(0, 21));
   oled.setCursor(0, 7); oled.print("SELECT: сохранить");
   oled.setCursor(90, 7); oled.print("EXIT");
-  oled.update();
+  oledFlush();
   if (selectBtn.isClick()) { showMessage("Файл сохранен!"); delay(1000); }
 }
 
@@ -933,65 +2012,34 @@ void handleMultiplicationTable() {
     oled.setCursor(0, 6); oled.print("UP/DN: 1-й, L/R: 2-й");
     oled.setCursor(0, 7); oled.print("SELECT: сброс");
     oled.setCursor(90, 7); oled.print("EXIT");
-    oled.update();
+    oledFlush();
 }
 
 
 // --- Игры ---
-void handleDinoGame() {
-  if (exitBtn.isClick()) { currentState = previousState; return; }
-  if (dino.gameOver) {
-    oled.clear();
-    oled.setCursor(3, 2); oled.setScale(2); oled.print("GAME OVER");
-    oled.setScale(1); oled.setCursor(2, 4); oled.print("Счет: "); oled.print(dino.score);
-    oled.setCursor(0, 6); oled.print("SELECT: заново");
-    oled.setCursor(0, 7); oled.print("EXIT: выход");
-    oled.update();
-    if (selectBtn.isClick()) { 
-        initDinoGame();
-    }
-    return; 
-  }
-  if (upBtn.isClick() && dino.dinoY >= 47 && !dino.jumping) {
-    // ИЗМЕНЕНО: Увеличена начальная скорость прыжка для большей высоты
-    dino.dinoSpeed = -3.5;
-    dino.jumping = true;
-    dino.crouching = false; 
-  }
-  if (downBtn.isHold()) {
-    dino.crouching = true;
-    if (dino.dinoY < 47) dino.dinoSpeed = 3.2;
-  } else {
-    dino.crouching = false;
-  }
-  unsigned long currentMillis = millis();
-  if (currentMillis - dino.lastScoreUpdate >= 100) {
-    dino.lastScoreUpdate = currentMillis;
+// Один шаг Динозавра (GAME_TICK_MS)
+void dinoStep() {
+  dino.ticks++;
+  if (dino.ticks % 5 == 0) {  // 100 мс
     dino.score++;
     // ИЗМЕНЕНО: Логика ускорения игры
     if (dino.score > 0 && dino.score % 100 == 0) {
-      dino.gameSpeed += 0.25; // Постепенно увеличиваем скорость
+      dino.gameSpeed += FIX(0.25); // Постепенно увеличиваем скорость
     }
   }
   
   // ИЗМЕНЕНО: Движение препятствия зависит от скорости игры
   dino.obstacleX -= dino.gameSpeed;
 
-  if (dino.obstacleX < -24) {
-    dino.obstacleX = 128;
+  if (dino.obstacleX < FIX(-24)) {
+    dino.obstacleX = FIX(128);
     dino.enemyType = random(0, 3);
   }
-  if (currentMillis - dino.lastLegUpdate >= 130) {
-    dino.lastLegUpdate = currentMillis;
-    dino.legFlag = !dino.legFlag;
-  }
-  if (currentMillis - dino.lastBirdUpdate >= 200 && dino.enemyType == 2) {
-    dino.lastBirdUpdate = currentMillis;
-    dino.birdFlag = !dino.birdFlag;
-  }
+  if (dino.ticks % 6 == 0) dino.legFlag = !dino.legFlag;                       // 120 мс
+  if (dino.ticks % 10 == 0 && dino.enemyType == 2) dino.birdFlag = !dino.birdFlag; // 200 мс
   if (dino.jumping || dino.crouching) {
-    dino.dinoY += dino.dinoSpeed;
-    dino.dinoSpeed += 0.17;
+    dino.dinoY = FIX_INT(FIX(dino.dinoY) + dino.dinoSpeed);
+    dino.dinoSpeed += FIX(0.17);
     if (dino.dinoY >= 47) {
       dino.dinoY = 47;
       dino.dinoSpeed = 0;
@@ -1002,27 +2050,57 @@ void handleDinoGame() {
   int dinoRight = dino.crouching ? 16 : 16;
   int dinoTop = dino.dinoY;
   int dinoBottom = dino.crouching ? dino.dinoY + 8 : dino.dinoY + 16;
-  int obstacleLeft = (int)dino.obstacleX;
-  int obstacleRight = (int)dino.obstacleX + (dino.enemyType == 1 ? 24 : 16);
+  int obstacleLeft = FIX_INT(dino.obstacleX);
+  int obstacleRight = FIX_INT(dino.obstacleX) + (dino.enemyType == 1 ? 24 : 16);
   int obstacleTop = (dino.enemyType == 2) ? 35 : 48;
   int obstacleBottom = (dino.enemyType == 2) ? 35 + 16 : 48 + 16;
   if ((dinoLeft < obstacleRight) && (dinoRight > obstacleLeft) && (dinoTop < obstacleBottom) && (dinoBottom > obstacleTop)) {
     dino.gameOver = true;
   }
+}
+
+void handleDinoGame() {
+  if (exitBtn.isClick()) { currentState = previousState; return; }
+  if (dino.gameOver) {
+    oled.clear();
+    oled.setCursor(3, 2); oled.setScale(2); oled.print("GAME OVER");
+    oled.setScale(1); oled.setCursor(2, 4); oled.print("Счет: "); oled.print(dino.score);
+    oled.setCursor(0, 6); oled.print("SELECT: заново");
+    oled.setCursor(0, 7); oled.print("EXIT: выход");
+    oledFlush();
+    if (selectBtn.isClick()) { 
+        initDinoGame();
+    }
+    return; 
+  }
+  if (upBtn.isClick() && dino.dinoY >= 47 && !dino.jumping) {
+    // ИЗМЕНЕНО: Увеличена начальная скорость прыжка для большей высоты
+    dino.dinoSpeed = FIX(-3.5);
+    dino.jumping = true;
+    dino.crouching = false; 
+  }
+  if (downBtn.isHold()) {
+    dino.crouching = true;
+    if (dino.dinoY < 47) dino.dinoSpeed = FIX(3.2);
+  } else {
+    dino.crouching = false;
+  }
+  for (int ticks = gameClockTicks(); ticks > 0 && !dino.gameOver; ticks--) dinoStep();
+  if (!gameClockShouldRender()) return;
   oled.clear();
   oled.setCursor(0, 0); oled.setScale(1); oled.print("Счет: "); oled.print(dino.score);
   oled.line(0, 63, 127, 63);
-  if (dino.obstacleX >= -24 && dino.obstacleX < 128) {
+  if (dino.obstacleX >= FIX(-24) && dino.obstacleX < FIX(128)) {
     switch (dino.enemyType) {
-      case 0: oled.drawBitmap((int)dino.obstacleX, 48, CactusSmall_bmp, 16, 16); break;
-      case 1: oled.drawBitmap((int)dino.obstacleX, 48, CactusBig_bmp, 24, 16); break;
-      case 2: oled.drawBitmap((int)dino.obstacleX, 35, dino.birdFlag ? BirdL_bmp : BirdR_bmp, 24, 16); break;
+      case 0: spriteBlit(FIX_INT(dino.obstacleX), 48, CactusSmall_bmp, 16, 16); break;
+      case 1: spriteBlit(FIX_INT(dino.obstacleX), 48, CactusBig_bmp, 24, 16); break;
+      case 2: spriteBlit(FIX_INT(dino.obstacleX), 35, dino.birdFlag ? BirdL_bmp : BirdR_bmp, 24, 16); break;
     }
   }
-  if (dino.gameOver) oled.drawBitmap(0, dino.dinoY, DinoStandDie_bmp, 16, 16);
-  else if (dino.crouching) oled.drawBitmap(0, 56, dino.legFlag ? DinoCroachL_bmp : DinoCroachR_bmp, 16, 8);
-  else oled.drawBitmap(0, dino.dinoY, dino.legFlag ? DinoStandL_bmp : DinoStandR_bmp, 16, 16);
-  oled.update();
+  if (dino.gameOver) spriteBlit(0, dino.dinoY, DinoStandDie_bmp, 16, 16);
+  else if (dino.crouching) spriteBlit(0, 56, dino.legFlag ? DinoCroachL_bmp : DinoCroachR_bmp, 16, 8);
+  else spriteBlit(0, dino.dinoY, dino.legFlag ? DinoStandL_bmp : DinoStandR_bmp, 16, 16);
+  oledFlush();
 }
 
 void handleSnakeGame() {
@@ -1033,7 +2111,7 @@ void handleSnakeGame() {
     oled.setScale(1); oled.setCursor(2, 4); oled.print("Счет: "); oled.print(snake.score);
     oled.setCursor(0, 6); oled.print("SELECT: заново");
     oled.setCursor(0, 7); oled.print("EXIT: выход");
-    oled.update();
+    oledFlush();
     if (selectBtn.isClick()) {
         initSnakeGame();
     }
@@ -1043,35 +2121,14 @@ void handleSnakeGame() {
   else if (downBtn.isClick() && snake.dirY == 0) { snake.dirX = 0; snake.dirY = 1; }
   else if (leftBtn.isClick() && snake.dirX == 0) { snake.dirX = -1; snake.dirY = 0; }
   else if (rightBtn.isClick() && snake.dirX == 0) { snake.dirX = 1; snake.dirY = 0; }
-  if (millis() - snake.lastMoveTime > snake.moveDelay) {
-    snake.lastMoveTime = millis();
-    int newX = snake.snakeX[0] + snake.dirX * snake.segmentSize;
-    int newY = snake.snakeY[0] + snake.dirY * snake.segmentSize;
-    if (newX < 0 || newX >= 128 || newY < 12 || newY >= 64) { snake.gameOver = true; return; }
-    for (int i = 0; i < snake.snakeLength; i++) {
-      if (newX == snake.snakeX[i] && newY == snake.snakeY[i]) { snake.gameOver = true; return; }
-    }
-    for (int i = snake.snakeLength - 1; i > 0; i--) {
-      snake.snakeX[i] = snake.snakeX[i - 1];
-      snake.snakeY[i] = snake.snakeY[i - 1];
-    }
-    snake.snakeX[0] = newX;
-    snake.snakeY[0] = newY;
-    if (newX == snake.foodX && newY == snake.foodY) {
-      if (snake.snakeLength < SnakeGame::MAX_LENGTH - 1) snake.snakeLength++;
-      snake.score += 10;
-      snake.moveDelay = max(80, snake.moveDelay - 3); 
-      snake.foodX = random(0, 32) * 4; snake.foodY = random(3, 16) * 4;
-    }
-  }
+  gameClockSetTick(snake.moveDelay);
+  for (int ticks = gameClockTicks(); ticks > 0 && !snake.gameOver; ticks--) snakeStep();
+  if (!gameClockShouldRender()) return;
   oled.clear();
   oled.setCursor(0, 0); oled.setScale(1); oled.print("Змейка Счет: "); oled.print(snake.score);
   oled.line(0, 11, 127, 11);
-  for (int i = 0; i < snake.snakeLength; i++) {
-    oled.rect(snake.snakeX[i], snake.snakeY[i], snake.snakeX[i] + snake.segmentSize - 1, snake.snakeY[i] + snake.segmentSize - 1, OLED_FILL);
-  }
-  oled.rect(snake.foodX, snake.foodY, snake.foodX + snake.segmentSize - 1, snake.foodY + snake.segmentSize - 1, OLED_STROKE);
-  oled.update();
+  tileMapRender(snake.board);
+  oledFlush();
 }
 
 void handleTetrisGame() {
@@ -1082,43 +2139,53 @@ void handleTetrisGame() {
     oled.setScale(1); oled.setCursor(2, 4); oled.print("Счет: "); oled.print(tetris.score);
     oled.setCursor(0, 6); oled.print("SELECT: заново");
     oled.setCursor(0, 7); oled.print("EXIT: выход");
-    oled.update();
+    oledFlush();
     if (selectBtn.isClick()) {
         initTetrisGame();
     }
     return;
   }
-  unsigned long currentTime = millis();
-  if (leftBtn.isClick()) if (!tetrisCheckCollision(tetris.pieceX - 1, tetris.pieceY)) tetris.pieceX--;
-  if (rightBtn.isClick()) if (!tetrisCheckCollision(tetris.pieceX + 1, tetris.pieceY)) tetris.pieceX++;
+  if (leftBtn.isClick() && !tetrisCheckCollision(tetris.pieceX - 1, tetris.pieceY)) { tetris.pieceX--; gameClockRequestRender(); }
+  if (rightBtn.isClick() && !tetrisCheckCollision(tetris.pieceX + 1, tetris.pieceY)) { tetris.pieceX++; gameClockRequestRender(); }
   if (downBtn.isHold()) tetris.dropDelay = 50; 
   else tetris.dropDelay = max(100, 500 - (tetris.score / 100) * 50); 
-  if (upBtn.isClick()) tetrisRotatePiece();
-  if (currentTime - tetris.lastDropTime > tetris.dropDelay) {
-    tetris.lastDropTime = currentTime;
+  if (upBtn.isClick()) { tetrisRotatePiece(); gameClockRequestRender(); }
+  gameClockSetTick(tetris.dropDelay);
+  if (selectBtn.isClick()) {
+    tetris.pieceY += tetrisDropDistance();
+    tetrisLockPiece();
+    gameClockStart(tetris.dropDelay);  // новая фигура начинает падать с полного шага
+  }
+  for (int ticks = gameClockTicks(); ticks > 0 && !tetris.gameOver; ticks--) {
     if (!tetrisCheckCollision(tetris.pieceX, tetris.pieceY + 1)) {
       tetris.pieceY++;
     } else {
-      tetrisPlacePiece();
-      tetrisClearLines();
-      tetrisNewPiece();
+      tetrisLockPiece();
     }
   }
+  if (!gameClockShouldRender()) return;
   oled.clear();
   oled.setCursor(0, 0); oled.setScale(1); oled.print("Тетрис "); oled.print(tetris.score);
-  int blockSize = 3; int fieldLeft = 40; int fieldTop = 14;
+  int blockSize = tetris.board.CELL_W; int fieldLeft = tetris.board.ORIGIN_X; int fieldTop = tetris.board.ORIGIN_Y;
   int fieldWidth = tetris.FIELD_WIDTH * blockSize; int fieldHeight = tetris.FIELD_HEIGHT * blockSize; 
   oled.rect(fieldLeft - 1, fieldTop - 1, fieldLeft + fieldWidth, fieldTop + fieldHeight, OLED_STROKE);
+  // Ячейки карты: поле, тень там, куда упадет фигура, и сама фигура поверх
+  uint16_t pieceRows[TetrisGame::FIELD_HEIGHT] = {0}, ghostRows[TetrisGame::FIELD_HEIGHT] = {0};
+  const TetrisShape& shape = tetrisShape(tetris.rotation);
+  int ghostY = tetris.pieceY + tetrisDropDistance();
+  for (int i = 0; i < 4; i++) {
+    uint16_t bits = (uint16_t)shape.rows[i] << (tetris.pieceX + shape.dx + TETRIS_WALL);
+    int py = tetris.pieceY + shape.dy + i, gy = ghostY + shape.dy + i;
+    if (py >= 0 && py < tetris.FIELD_HEIGHT) pieceRows[py] |= bits;
+    if (gy >= 0 && gy < tetris.FIELD_HEIGHT) ghostRows[gy] |= bits;
+  }
   for (int y = 0; y < tetris.FIELD_HEIGHT; y++) {
+    uint16_t solid = (tetris.rows[y] | pieceRows[y]) >> TETRIS_WALL, ghost = ghostRows[y] >> TETRIS_WALL;
     for (int x = 0; x < tetris.FIELD_WIDTH; x++) {
-      if (tetris.field[y][x]) oled.rect(fieldLeft + x * blockSize, fieldTop + y * blockSize, fieldLeft + x * blockSize + blockSize - 1, fieldTop + y * blockSize + blockSize - 1, OLED_FILL);
+      tileMapSet(tetris.board, x, y, (solid & (1 << x)) ? TILE_BLOCK : (ghost & (1 << x)) ? TILE_GHOST : 0);
     }
   }
-  for (int i = 0; i < 4; i++) {
-    int px = tetris.currentPiece[i][0] + tetris.pieceX;
-    int py = tetris.currentPiece[i][1] + tetris.pieceY;
-    oled.rect(fieldLeft + px * blockSize, fieldTop + py * blockSize, fieldLeft + px * blockSize + blockSize - 1, fieldTop + py * blockSize + blockSize - 1, OLED_FILL);
-  }
+  tileMapRender(tetris.board);
   int previewX = fieldLeft + fieldWidth + 10; int previewY = fieldTop + 10;
   oled.setCursor(previewX - 5, fieldTop); oled.print("След:");
   for (int i = 0; i < 4; i++) {
@@ -1126,7 +2193,7 @@ void handleTetrisGame() {
     int py = PIECES[tetris.nextPieceType][i][1];
     oled.rect(previewX + px * blockSize, previewY + py * blockSize, previewX + px * blockSize + blockSize -1, previewY + py * blockSize + blockSize -1, OLED_FILL);
   }
-  oled.update();
+  oledFlush();
 }
 
 void handleArkanoidGame() {
@@ -1137,48 +2204,45 @@ void handleArkanoidGame() {
     oled.setScale(1); oled.setCursor(2, 4); oled.print("Счет: "); oled.print(arkanoid.score);
     oled.setCursor(0, 6); oled.print("SELECT: заново");
     oled.setCursor(0, 7); oled.print("EXIT: выход");
-    oled.update();
+    oledFlush();
     if (selectBtn.isClick()) {
         initArkanoidGame();
     }
     return; 
   }
-  if (gameTimer.isReady()) {
+  for (int ticks = gameClockTicks(); ticks > 0 && !arkanoid.gameOver; ticks--) {
     if (leftBtn.isHold()) arkanoid.paddleX -= 4;
     if (rightBtn.isHold()) arkanoid.paddleX += 4;
     if (arkanoid.paddleX < 0) arkanoid.paddleX = 0;
     if (arkanoid.paddleX > 128 - arkanoid.paddleWidth) arkanoid.paddleX = 128 - arkanoid.paddleWidth;
-    arkanoid.ballX += arkanoid.ballVelX;
-    arkanoid.ballY += arkanoid.ballVelY;
-    if (arkanoid.ballX <= 0 || arkanoid.ballX >= 127 - arkanoid.ballSize) arkanoid.ballVelX = -arkanoid.ballVelX;
-    if (arkanoid.ballY <= 12) arkanoid.ballVelY = -arkanoid.ballVelY;
-    if (arkanoid.ballY + arkanoid.ballSize >= 62 && arkanoid.ballY <= 63 && arkanoid.ballX + arkanoid.ballSize >= arkanoid.paddleX && arkanoid.ballX <= arkanoid.paddleX + arkanoid.paddleWidth) {
-        arkanoid.ballVelY = -abs(arkanoid.ballVelY);
+    fixIntegrate(arkanoid.ball, arkanoid.ballVel);
+    int ballX = FIX_INT(arkanoid.ball.x), ballY = FIX_INT(arkanoid.ball.y);
+    if (ballX <= 0 || ballX >= 127 - arkanoid.ballSize) arkanoid.ballVel.x = -arkanoid.ballVel.x;
+    if (ballY <= 12) arkanoid.ballVel.y = -arkanoid.ballVel.y;
+    if (ballY + arkanoid.ballSize >= 62 && ballY <= 63 && ballX + arkanoid.ballSize >= arkanoid.paddleX && ballX <= arkanoid.paddleX + arkanoid.paddleWidth) {
+        arkanoid.ballVel.y = -abs(arkanoid.ballVel.y);
     }
     int brickWidth = 10; int brickHeight = 4;
-    int brickCol = (arkanoid.ballX - 2) / (brickWidth + 2);
-    int brickRow = (arkanoid.ballY - 12) / (brickHeight + 1);
+    int brickCol = (ballX - 2) / (brickWidth + 2);
+    int brickRow = (ballY - 12) / (brickHeight + 1);
     if (brickCol >= 0 && brickCol < 10 && brickRow >= 0 && brickRow < 5) {
-        if (arkanoid.bricks[brickRow][brickCol]) {
-            arkanoid.bricks[brickRow][brickCol] = false;
-            arkanoid.ballVelY = -arkanoid.ballVelY;
+        if (tileMapGet(arkanoid.bricks, brickCol, brickRow)) {
+            tileMapSet(arkanoid.bricks, brickCol, brickRow, 0);
+            arkanoid.ballVel.y = -arkanoid.ballVel.y;
             arkanoid.score += 10;
         }
     }
-    if (arkanoid.ballY >= 65) arkanoid.gameOver = true;
+    if (ballY >= 65) arkanoid.gameOver = true;
   }
+  if (!gameClockShouldRender()) return;
   oled.clear();
   oled.setCursor(0, 0); oled.setScale(1); oled.print("Счет: "); oled.print(arkanoid.score);
   oled.line(0, 10, 127, 10);
-  int brickWidth = 10; int brickHeight = 4;
-  for (int y = 0; y < 5; y++) {
-    for (int x = 0; x < 10; x++) {
-      if (arkanoid.bricks[y][x]) oled.rect(x * (brickWidth + 2) + 2, y * (brickHeight + 1) + 12, x * (brickWidth + 2) + brickWidth, y * (brickHeight + 1) + 12 + brickHeight -1, OLED_FILL);
-    }
-  }
+  tileMapRender(arkanoid.bricks);
   oled.rect(arkanoid.paddleX, 62, arkanoid.paddleX + arkanoid.paddleWidth - 1, 63, OLED_FILL);
-  oled.rect(arkanoid.ballX, arkanoid.ballY, arkanoid.ballX + arkanoid.ballSize - 1, arkanoid.ballY + arkanoid.ballSize - 1, OLED_FILL);
-  oled.update();
+  int ballX = FIX_INT(arkanoid.ball.x), ballY = FIX_INT(arkanoid.ball.y);
+  oled.rect(ballX, ballY, ballX + arkanoid.ballSize - 1, ballY + arkanoid.ballSize - 1, OLED_FILL);
+  oledFlush();
 }
 
 void handlePongGame() {
@@ -1189,51 +2253,54 @@ void handlePongGame() {
         if (pong.score1 >= 5) { oled.print("ИГРОК 1"); oled.setCursor(15, 4); oled.print("ПОБЕДИЛ!"); }
         else { oled.print("КОМПЬЮТЕР"); oled.setCursor(15,4); oled.print("ПОБЕДИЛ!"); }
         oled.setScale(1); oled.setCursor(0, 7); oled.print("SELECT: заново EXIT");
-        oled.update();
+        oledFlush();
         if (selectBtn.isClick()) {
             initPongGame();
         }
         return; 
     }
-    if (upBtn.isHold()) pong.paddle1Y = max(12.0f, pong.paddle1Y - 2);
-    if (downBtn.isHold()) pong.paddle1Y = min((float)(64 - pong.paddleHeight), pong.paddle1Y + 2);
-    float targetY = pong.ballY - (pong.paddleHeight / 2.0f);
-    float dy = targetY - pong.paddle2Y;
-    pong.paddle2Y += dy * 0.1; 
-    pong.paddle2Y = constrain(pong.paddle2Y, 12.0f, 64.0f - pong.paddleHeight);
-    if (gameTimer.isReady()) {
-        pong.ballX += pong.ballVelX;
-        pong.ballY += pong.ballVelY;
-        if (pong.ballY <= 12 || pong.ballY >= 63) pong.ballVelY = -pong.ballVelY;
-        if (pong.ballX <= 3 && pong.ballX >= 1 && pong.ballY >= pong.paddle1Y && pong.ballY <= pong.paddle1Y + pong.paddleHeight) {
-            pong.ballVelX = abs(pong.ballVelX);
-            float relativeIntersectY = (pong.paddle1Y + (pong.paddleHeight / 2.0)) - pong.ballY;
-            pong.ballVelY = -(relativeIntersectY / (pong.paddleHeight / 2.0)) * 2;
+    fix_t paddleHalf = FIX(pong.paddleHeight / 2);
+    for (int ticks = gameClockTicks(); ticks > 0 && !pong.gameOver; ticks--) {
+        if (upBtn.isHold()) pong.paddle1Y = max(FIX(12), pong.paddle1Y - FIX(2));
+        if (downBtn.isHold()) pong.paddle1Y = min(FIX(64 - pong.paddleHeight), pong.paddle1Y + FIX(2));
+        fix_t targetY = pong.ball.y - paddleHalf;
+        fix_t dy = targetY - pong.paddle2Y;
+        pong.paddle2Y += dy / 10;
+        pong.paddle2Y = constrain(pong.paddle2Y, FIX(12), FIX(64 - pong.paddleHeight));
+        fixIntegrate(pong.ball, pong.ballVel);
+        if (pong.ball.y <= FIX(12) || pong.ball.y >= FIX(63)) pong.ballVel.y = -pong.ballVel.y;
+        if (pong.ball.x <= FIX(3) && pong.ball.x >= FIX(1) && pong.ball.y >= pong.paddle1Y && pong.ball.y <= pong.paddle1Y + FIX(pong.paddleHeight)) {
+            pong.ballVel.x = abs(pong.ballVel.x);
+            fix_t relativeIntersectY = (pong.paddle1Y + paddleHalf) - pong.ball.y;
+            pong.ballVel.y = -relativeIntersectY * 2 / (pong.paddleHeight / 2);
         }
-        if (pong.ballX >= 124 && pong.ballX <= 126 && pong.ballY >= pong.paddle2Y && pong.ballY <= pong.paddle2Y + pong.paddleHeight) {
-            pong.ballVelX = -abs(pong.ballVelX);
-            float relativeIntersectY = (pong.paddle2Y + (pong.paddleHeight / 2.0)) - pong.ballY;
-            pong.ballVelY = -(relativeIntersectY / (pong.paddleHeight / 2.0)) * 2;
+        if (pong.ball.x >= FIX(124) && pong.ball.x <= FIX(126) && pong.ball.y >= pong.paddle2Y && pong.ball.y <= pong.paddle2Y + FIX(pong.paddleHeight)) {
+            pong.ballVel.x = -abs(pong.ballVel.x);
+            fix_t relativeIntersectY = (pong.paddle2Y + paddleHalf) - pong.ball.y;
+            pong.ballVel.y = -relativeIntersectY * 2 / (pong.paddleHeight / 2);
         }
-        if (pong.ballX < 0) {
+        if (pong.ball.x < 0) {
             pong.score2++;
             if (pong.score2 >= 5) pong.gameOver = true;
-            else { pong.ballX = 64; pong.ballY = 32; pong.ballVelX = -1.5; pong.ballVelY = random(-10, 11) / 10.0; }
+            else { pong.ball = {FIX(64), FIX(32)}; pong.ballVel = {FIX(-1.5), fixRandom(-10, 11, 10)}; }
         }
-        if (pong.ballX > 127) {
+        if (pong.ball.x > FIX(127)) {
             pong.score1++;
             if (pong.score1 >= 5) pong.gameOver = true;
-            else { pong.ballX = 64; pong.ballY = 32; pong.ballVelX = 1.5; pong.ballVelY = random(-10, 11) / 10.0; }
+            else { pong.ball = {FIX(64), FIX(32)}; pong.ballVel = {FIX(1.5), fixRandom(-10, 11, 10)}; }
         }
     }
+    if (!gameClockShouldRender()) return;
     oled.clear();
     oled.setCursor(0, 0); oled.setScale(1); oled.print(pong.score1);
     oled.setCursor(120, 0); oled.print(pong.score2);
     oled.line(0, 11, 127, 11); oled.line(0, 63, 127, 63); oled.line(64, 12, 64, 63, OLED_STROKE);
-    oled.rect(1, pong.paddle1Y, 2, pong.paddle1Y + pong.paddleHeight - 1, OLED_FILL);
-    oled.rect(125, pong.paddle2Y, 126, pong.paddle2Y + pong.paddleHeight - 1, OLED_FILL);
-    oled.rect(pong.ballX, pong.ballY, pong.ballX + pong.ballSize - 1, pong.ballY + pong.ballSize - 1, OLED_FILL);
-    oled.update();
+    int paddle1Y = FIX_INT(pong.paddle1Y), paddle2Y = FIX_INT(pong.paddle2Y);
+    int ballX = FIX_INT(pong.ball.x), ballY = FIX_INT(pong.ball.y);
+    oled.rect(1, paddle1Y, 2, paddle1Y + pong.paddleHeight - 1, OLED_FILL);
+    oled.rect(125, paddle2Y, 126, paddle2Y + pong.paddleHeight - 1, OLED_FILL);
+    oled.rect(ballX, ballY, ballX + pong.ballSize - 1, ballY + pong.ballSize - 1, OLED_FILL);
+    oledFlush();
 }
 
 void handleAsteroidsGame() {
@@ -1244,121 +2311,113 @@ void handleAsteroidsGame() {
         oled.setScale(1); oled.setCursor(2, 4); oled.print("Счет: "); oled.print(asteroids.score);
         oled.setCursor(0, 6); oled.print("SELECT: заново");
         oled.setCursor(0, 7); oled.print("EXIT: выход");
-        oled.update();
+        oledFlush();
         if (selectBtn.isClick()) {
             initAsteroidsGame();
         }
         return; 
     }
-    if (leftBtn.isHold()) asteroids.shipAngle -= 0.1;
-    if (rightBtn.isHold()) asteroids.shipAngle += 0.1;
-    if (upBtn.isHold()) {
-        asteroids.thrusting = true;
-        asteroids.shipVelX += sin(asteroids.shipAngle) * 0.1;
-        asteroids.shipVelY -= cos(asteroids.shipAngle) * 0.1;
-    } else {
-        asteroids.thrusting = false;
-    }
+    asteroids.thrusting = upBtn.isHold();
     if (selectBtn.isClick()) {
         for (int i = 0; i < asteroids.MAX_BULLETS; i++) {
-            if (!asteroids.bullets[i].active) {
-                asteroids.bullets[i].active = true; asteroids.bullets[i].x = asteroids.shipX;
-                asteroids.bullets[i].y = asteroids.shipY; asteroids.bullets[i].velX = sin(asteroids.shipAngle) * 3;
-                asteroids.bullets[i].velY = -cos(asteroids.shipAngle) * 3;
+            AsteroidsGame::Bullet& bullet = asteroids.bullets[i];
+            if (!bullet.active) {
+                bullet.active = true; bullet.pos = asteroids.ship;
+                bullet.vel = fixHeading(asteroids.shipAngle, FIX(3));
                 break;
             }
         }
     }
-    if (gameTimer.isReady()) {
-        asteroids.shipX += asteroids.shipVelX; asteroids.shipY += asteroids.shipVelY;
-        asteroids.shipVelX *= 0.98; asteroids.shipVelY *= 0.98;
-        if (asteroids.shipX < 0) asteroids.shipX = 127; if (asteroids.shipX > 127) asteroids.shipX = 0;
-        if (asteroids.shipY < 12) asteroids.shipY = 63; if (asteroids.shipY > 63) asteroids.shipY = 12;
+    for (int ticks = gameClockTicks(); ticks > 0 && !asteroids.gameOver; ticks--) {
+        if (leftBtn.isHold()) asteroids.shipAngle -= AsteroidsGame::TURN_STEP;
+        if (rightBtn.isHold()) asteroids.shipAngle += AsteroidsGame::TURN_STEP;
+        if (asteroids.thrusting) {
+            FixVec thrust = fixHeading(asteroids.shipAngle, FIX(0.1));
+            asteroids.shipVel.x += thrust.x; asteroids.shipVel.y += thrust.y;
+        }
+        fixIntegrate(asteroids.ship, asteroids.shipVel);
+        fixScale(asteroids.shipVel, FIX(0.98));
+        if (asteroids.ship.x < 0) asteroids.ship.x = FIX(127); if (asteroids.ship.x > FIX(127)) asteroids.ship.x = 0;
+        if (asteroids.ship.y < FIX(12)) asteroids.ship.y = FIX(63); if (asteroids.ship.y > FIX(63)) asteroids.ship.y = FIX(12);
         for (int i = 0; i < asteroids.MAX_ASTEROIDS; i++) {
-            if (asteroids.asteroids[i].active) {
-                asteroids.asteroids[i].x += asteroids.asteroids[i].velX;
-                asteroids.asteroids[i].y += asteroids.asteroids[i].velY;
-                if (asteroids.asteroids[i].x < -10) asteroids.asteroids[i].x = 138;
-                if (asteroids.asteroids[i].x > 138) asteroids.asteroids[i].x = -10;
-                if (asteroids.asteroids[i].y < 2) asteroids.asteroids[i].y = 73;
-                if (asteroids.asteroids[i].y > 73) asteroids.asteroids[i].y = 2;
+            AsteroidsGame::Asteroid& rock = asteroids.asteroids[i];
+            if (rock.active) {
+                fixIntegrate(rock.pos, rock.vel);
+                if (rock.pos.x < FIX(-10)) rock.pos.x = FIX(138);
+                if (rock.pos.x > FIX(138)) rock.pos.x = FIX(-10);
+                if (rock.pos.y < FIX(2)) rock.pos.y = FIX(73);
+                if (rock.pos.y > FIX(73)) rock.pos.y = FIX(2);
             }
         }
         for (int i = 0; i < asteroids.MAX_BULLETS; i++) {
-            if (asteroids.bullets[i].active) {
-                asteroids.bullets[i].x += asteroids.bullets[i].velX;
-                asteroids.bullets[i].y += asteroids.bullets[i].velY;
-                if (asteroids.bullets[i].x < 0 || asteroids.bullets[i].x > 127 || asteroids.bullets[i].y < 12 || asteroids.bullets[i].y > 63) {
-                    asteroids.bullets[i].active = false;
+            AsteroidsGame::Bullet& bullet = asteroids.bullets[i];
+            if (bullet.active) {
+                fixIntegrate(bullet.pos, bullet.vel);
+                if (bullet.pos.x < 0 || bullet.pos.x > FIX(127) || bullet.pos.y < FIX(12) || bullet.pos.y > FIX(63)) {
+                    bullet.active = false;
                 }
             }
         }
         for (int i = 0; i < asteroids.MAX_BULLETS; i++) {
-            if (asteroids.bullets[i].active) {
+            AsteroidsGame::Bullet& bullet = asteroids.bullets[i];
+            if (bullet.active) {
                 for (int j = 0; j < asteroids.MAX_ASTEROIDS; j++) {
-                    if (asteroids.asteroids[j].active) {
-                        float dx = asteroids.bullets[i].x - asteroids.asteroids[j].x;
-                        float dy = asteroids.bullets[i].y - asteroids.asteroids[j].y;
-                        float distance = sqrt(dx*dx + dy*dy);
-                        float asteroidRadius = (asteroids.asteroids[j].size + 1) * 4;
-                        if (distance < asteroidRadius) {
-                            asteroids.bullets[i].active = false;
-                            asteroids.score += (3 - asteroids.asteroids[j].size) * 10;
-                            if (asteroids.asteroids[j].size > 0) {
-                                for (int k = 0; k < 2; k++) {
-                                    for (int l = 0; l < asteroids.MAX_ASTEROIDS; l++) {
-                                        if (!asteroids.asteroids[l].active) {
-                                            asteroids.asteroids[l].active = true;
-                                            asteroids.asteroids[l].x = asteroids.asteroids[j].x;
-                                            asteroids.asteroids[l].y = asteroids.asteroids[j].y;
-                                            asteroids.asteroids[l].velX = asteroids.asteroids[j].velX + random(-10, 11) / 10.0;
-                                            asteroids.asteroids[l].velY = asteroids.asteroids[j].velY + random(-10, 11) / 10.0;
-                                            asteroids.asteroids[l].size = asteroids.asteroids[j].size - 1;
-                                            break;
-                                        }
+                    AsteroidsGame::Asteroid& rock = asteroids.asteroids[j];
+                    if (rock.active && fixWithinRadius(bullet.pos, rock.pos, FIX((rock.size + 1) * 4))) {
+                        bullet.active = false;
+                        asteroids.score += (3 - rock.size) * 10;
+                        if (rock.size > 0) {
+                            for (int k = 0; k < 2; k++) {
+                                for (int l = 0; l < asteroids.MAX_ASTEROIDS; l++) {
+                                    AsteroidsGame::Asteroid& piece = asteroids.asteroids[l];
+                                    if (!piece.active) {
+                                        piece.active = true;
+                                        piece.pos = rock.pos;
+                                        piece.vel.x = rock.vel.x + fixRandom(-10, 11, 10);
+                                        piece.vel.y = rock.vel.y + fixRandom(-10, 11, 10);
+                                        piece.size = rock.size - 1;
+                                        break;
                                     }
                                 }
                             }
-                            asteroids.asteroids[j].active = false;
-                            break;
                         }
+                        rock.active = false;
+                        break;
                     }
                 }
             }
         }
         for (int i = 0; i < asteroids.MAX_ASTEROIDS; i++) {
-            if (asteroids.asteroids[i].active) {
-                float dx = asteroids.shipX - asteroids.asteroids[i].x;
-                float dy = asteroids.shipY - asteroids.asteroids[i].y;
-                float distance = sqrt(dx*dx + dy*dy);
-                float asteroidRadius = (asteroids.asteroids[i].size + 1) * 4;
-                if (distance < asteroidRadius + 2) asteroids.gameOver = true;
-            }
+            AsteroidsGame::Asteroid& rock = asteroids.asteroids[i];
+            if (rock.active && fixWithinRadius(asteroids.ship, rock.pos, FIX((rock.size + 1) * 4 + 2))) asteroids.gameOver = true;
         }
     }
+    if (!gameClockShouldRender()) return;
     oled.clear();
     oled.setCursor(0, 0); oled.setScale(1); oled.print("Счет: "); oled.print(asteroids.score);
     oled.line(0, 11, 127, 11);
     if (!asteroids.gameOver) {
-        int x1 = asteroids.shipX + 4 * sin(asteroids.shipAngle); int y1 = asteroids.shipY - 4 * cos(asteroids.shipAngle);
-        int x2 = asteroids.shipX + 3 * sin(asteroids.shipAngle + 2.5); int y2 = asteroids.shipY - 3 * cos(asteroids.shipAngle + 2.5);
-        int x3 = asteroids.shipX + 3 * sin(asteroids.shipAngle - 2.5); int y3 = asteroids.shipY - 3 * cos(asteroids.shipAngle - 2.5);
+        int shipX = FIX_INT(asteroids.ship.x), shipY = FIX_INT(asteroids.ship.y);
+        FixVec nose = fixHeading(asteroids.shipAngle, FIX(4));
+        FixVec wing1 = fixHeading(asteroids.shipAngle + AsteroidsGame::WING_ANGLE, FIX(3));
+        FixVec wing2 = fixHeading(asteroids.shipAngle - AsteroidsGame::WING_ANGLE, FIX(3));
+        int x1 = FIX_INT(asteroids.ship.x + nose.x); int y1 = FIX_INT(asteroids.ship.y + nose.y);
+        int x2 = FIX_INT(asteroids.ship.x + wing1.x); int y2 = FIX_INT(asteroids.ship.y + wing1.y);
+        int x3 = FIX_INT(asteroids.ship.x + wing2.x); int y3 = FIX_INT(asteroids.ship.y + wing2.y);
         oled.line(x1, y1, x2, y2); oled.line(x2, y2, x3, y3); oled.line(x3, y3, x1, y1);
         if (asteroids.thrusting) {
-            int flameX = asteroids.shipX - 4 * sin(asteroids.shipAngle); int flameY = asteroids.shipY + 4 * cos(asteroids.shipAngle);
-            oled.line(asteroids.shipX, asteroids.shipY, flameX, flameY);
+            oled.line(shipX, shipY, FIX_INT(asteroids.ship.x - nose.x), FIX_INT(asteroids.ship.y - nose.y));
         }
     }
     for (int i = 0; i < asteroids.MAX_ASTEROIDS; i++) {
-        if (asteroids.asteroids[i].active) {
-            float radius = (asteroids.asteroids[i].size + 1) * 4;
-            oled.circle(asteroids.asteroids[i].x, asteroids.asteroids[i].y, radius, OLED_STROKE);
-        }
+        const AsteroidsGame::Asteroid& rock = asteroids.asteroids[i];
+        if (rock.active) oled.circle(FIX_INT(rock.pos.x), FIX_INT(rock.pos.y), (rock.size + 1) * 4, OLED_STROKE);
     }
     for (int i = 0; i < asteroids.MAX_BULLETS; i++) {
-        if (asteroids.bullets[i].active) oled.dot(asteroids.bullets[i].x, asteroids.bullets[i].y);
+        const AsteroidsGame::Bullet& bullet = asteroids.bullets[i];
+        if (bullet.active) oled.dot(FIX_INT(bullet.pos.x), FIX_INT(bullet.pos.y));
     }
-    oled.update();
+    oledFlush();
 }
 
 void handleFlappyBirdGame() {
@@ -1369,17 +2428,17 @@ void handleFlappyBirdGame() {
         oled.setScale(1); oled.setCursor(2, 4); oled.print("Счет: "); oled.print(flappyBird.score);
         oled.setCursor(0, 6); oled.print("SELECT: заново");
         oled.setCursor(0, 7); oled.print("EXIT: выход");
-        oled.update();
+        oledFlush();
         if (selectBtn.isClick()) {
             initFlappyBirdGame();
         }
         return; 
     }
-    if (selectBtn.isClick() || upBtn.isClick()) flappyBird.birdVel = -2.5;
-    if (gameTimer.isReady()) {
-        flappyBird.birdVel += 0.2;
+    if (selectBtn.isClick() || upBtn.isClick()) flappyBird.birdVel = FIX(-2.5);
+    for (int ticks = gameClockTicks(); ticks > 0 && !flappyBird.gameOver; ticks--) {
+        flappyBird.birdVel += FIX(0.2);
         flappyBird.birdY += flappyBird.birdVel;
-        if (flappyBird.birdY < 12 || flappyBird.birdY > 60) flappyBird.gameOver = true;
+        if (flappyBird.birdY < FIX(12) || flappyBird.birdY > FIX(60)) flappyBird.gameOver = true;
         for (int i = 0; i < flappyBird.MAX_PIPES; i++) {
             flappyBird.pipes[i].x -= 2;
             if (flappyBird.pipes[i].x < -20) {
@@ -1397,23 +2456,24 @@ void handleFlappyBirdGame() {
                 flappyBird.score++;
             }
             if (flappyBird.pipes[i].x < 24 && flappyBird.pipes[i].x > 16) { // Bird is at x=20, width 4
-                if (flappyBird.birdY < flappyBird.pipes[i].gapY || flappyBird.birdY + 4 > flappyBird.pipes[i].gapY + 20) {
+                if (flappyBird.birdY < FIX(flappyBird.pipes[i].gapY) || flappyBird.birdY + FIX(4) > FIX(flappyBird.pipes[i].gapY + 20)) {
                     flappyBird.gameOver = true;
                 }
             }
         }
     }
+    if (!gameClockShouldRender()) return;
     oled.clear();
     oled.setCursor(0, 0); oled.setScale(1); oled.print("Счет: "); oled.print(flappyBird.score);
     oled.line(0, 11, 127, 11); oled.line(0, 63, 127, 63);
-    if (!flappyBird.gameOver) oled.rect(20, flappyBird.birdY, 23, flappyBird.birdY + 3, OLED_FILL);
+    if (!flappyBird.gameOver) oled.rect(20, FIX_INT(flappyBird.birdY), 23, FIX_INT(flappyBird.birdY) + 3, OLED_FILL);
     for (int i = 0; i < flappyBird.MAX_PIPES; i++) {
         if (flappyBird.pipes[i].x > -20 && flappyBird.pipes[i].x < 128) {
             oled.rect(flappyBird.pipes[i].x, 12, flappyBird.pipes[i].x + 19, flappyBird.pipes[i].gapY, OLED_FILL);
             oled.rect(flappyBird.pipes[i].x, flappyBird.pipes[i].gapY + 20, flappyBird.pipes[i].x + 19, 63, OLED_FILL);
         }
     }
-    oled.update();
+    oledFlush();
 }
 
 void drawDiceFace(int value, int x, int y, int size) {
@@ -1453,48 +2513,21 @@ void handleDiceGame() {
     oled.setCursor(10, 4); oled.print("для броска.");
   }
   oled.setCursor(0, 7); oled.setScale(1); oled.print("SELECT: бросить");
-  oled.update();
+  oledFlush();
 }
 
 // --- Функционал читалки ---
 
 int getReaderFilesCount() {
-  File root = LittleFS.open("/");
-  int count = 0;
-  File file = root.openNextFile();
-  while (file) {
-    String filename = file.name();
-    // ИЗМЕНЕНО: Ищем .h вместо .tos
-    if (filename.endsWith(".txt") || filename.endsWith(".h")) {
-      count++;
-    }
-    file.close();
-    file = root.openNextFile();
-  }
-  root.close();
-  return count;
+  FsLock lock;
+  return dirIndexGet().readerCount;
 }
 
 String getReaderFilenameByIndex(int idx) {
-  File root = LittleFS.open("/");
-  int i = 0;
-  File file = root.openNextFile();
-  while (file) {
-    String filename = file.name();
-    // ИЗМЕНЕНО: Ищем .h вместо .tos
-    if (filename.endsWith(".txt") || filename.endsWith(".h")) {
-      if (i == idx) {
-        file.close();
-        root.close();
-        return filename;
-      }
-      i++;
-    }
-    file.close();
-    file = root.openNextFile();
-  }
-  root.close();
-  return "";
+  FsLock lock;
+  DirIndex& dir = dirIndexGet();
+  if (idx < 0 || idx >= dir.readerCount) return "";
+  return dirEntryName(dir.entries[dir.reader[idx]]);
 }
 
 void updateReaderCursor() {
@@ -1510,7 +2543,7 @@ void updateReaderCursor() {
   }
   oled.setCursor(0, 2 + (readerApp.cursor % 6));
   oled.print(">");
-  oled.update();
+  oledFlush();
 }
 
 bool drawReaderFileMenu() {
@@ -1521,124 +2554,868 @@ bool drawReaderFileMenu() {
   if (readerApp.filesCount == 0) {
     oled.setCursor(10, 4);
     oled.print("Файлов нет :(");
-    oled.update();
+    oledFlush();
     return false;
   }
   updateReaderCursor();
   return true;
 }
 
-// НОВАЯ ФУНКЦИЯ: Взята из catoslite.cpp для парсинга .h файлов
-uint8_t parseHFile(uint8_t *img, File &file) {
-  int imgLen = 0;
-  memset(img, 0, 1024); // Очистка буфера
+// --- Разметка текста на страницы ---
+// Одна и та же раскладка служит и для отрисовки, и для построения индекса страниц,
+// поэтому границы страниц в индексе всегда совпадают с тем, что на экране.
+// Страница начинается с первого непробельного символа после предыдущей.
+#define READER_LINES 7
+#define READER_COLS 21
+#define READER_LAYOUT_VERSION 2         // менять при любом изменении раскладки: старые индексы сбросятся
+#define READER_INDEX_MAGIC 0x58444954   // "TIDX"
+#define READER_INDEX_BUDGET_MS 3        // фоновая разметка за один проход loop()
+
+// Байт файла как он лежит на флеше или -1 за концом; 256-байтный блок перечитывается,
+// только если pos вне буфера
+int textRawByteAt(TextCursor& c, uint32_t pos) {
+  if (pos - c.bufStart >= c.bufLen) {
+    if (pos >= c.rawSize) return -1;
+    FsLock lock;  // только на чтение блока: разметка идет без него, и веб-задача успевает между блоками
+    c.file.seek(pos);
+    c.bufStart = pos;
+    c.bufLen = c.file.read(c.buf, READER_BLOCK);
+    if (!c.bufLen) return -1;
+  }
+  return c.buf[pos - c.bufStart];
+}
+
+// --- Сжатый текст .tz ---
+// Заголовок 12 байт: "TTZ", версия 1, исходный размер (uint32 LE), размер блока (uint16 LE),
+// число блоков (uint16 LE). Дальше индекс: число блоков + 1 смещений (uint32 LE) начала
+// сжатых данных каждого блока, последнее - конец файла. Блок - LZ4-подобный поток без
+// ссылок наружу: токен (старшие 4 бита - число литералов, младшие - длина совпадения - 4,
+// 15 продолжается байтами до первого не 255), литералы, смещение назад (uint16 LE).
+// Последняя последовательность блока - только литералы. Готовит файлы tools/txt2tz.py.
+// Смещения для читалки - в исходном тексте: переход к странице распаковывает один блок.
+#define TZ_HEADER_SIZE 12
+#define TZ_VERSION 1
+
+uint32_t textRawU32(TextCursor& c, uint32_t pos) {
+  uint32_t v = 0;
+  for (uint8_t i = 0; i < 4; i++) v |= (uint32_t)(textRawByteAt(c, pos + i) & 0xFF) << (8 * i);
+  return v;
+}
 
-  // Пропускаем все символы до '{'
-  while (file.available()) {
-    if (file.read() == '{') break;
+// Длина с продолжением: 15 в токене, затем байты, пока не встретится не 255
+bool lzLength(TextCursor& c, uint32_t& src, uint32_t& len) {
+  if (len != 15) return true;
+  for (;;) {
+    int b = textRawByteAt(c, src++);
+    if (b < 0) return false;
+    len += b;
+    if (b != 255) return true;
   }
+}
 
-  // Читаем данные до '}' или конца файла
-  while (file.available() && imgLen < 1024) {
-    char c = file.read();
-    if (c == '}') break; // Конец данных
-    
-    // Парсим HEX-значения вида 0xXX
-    if (c == '0' && file.peek() == 'x') {
-      file.read(); // Пропускаем 'x'
-      char hex[3] = {0};
-      hex[0] = file.read();
-      hex[1] = file.read();
-      img[imgLen++] = strtoul(hex, NULL, 16); // Конвертируем HEX в байт
+bool lzUnpack(TextCursor& c, uint32_t src, uint32_t end, uint8_t* out, uint16_t outLen) {
+  uint16_t o = 0;
+  while (src < end) {
+    int token = textRawByteAt(c, src++);
+    uint32_t lit = token >> 4, len = token & 15;
+    if (token < 0 || !lzLength(c, src, lit) || o + lit > outLen) return false;
+    for (; lit; lit--) {
+      int b = textRawByteAt(c, src++);
+      if (b < 0) return false;
+      out[o++] = b;
     }
-    yield(); // Для стабильности ESP
+    if (src >= end) break;
+    uint16_t offset = textRawByteAt(c, src) | (textRawByteAt(c, src + 1) << 8);
+    src += 2;
+    if (!lzLength(c, src, len)) return false;
+    len += 4;
+    if (!offset || offset > o || o + len > outLen) return false;
+    for (; len; len--, o++) out[o] = out[o - offset];
   }
+  return o == outLen;
+}
 
-  return (imgLen > 0) ? 0 : 1; // 0 = успех, 1 = ошибка (если ничего не найдено)
+bool textUnpackBlock(TextCursor& c, uint32_t pos) {
+  if (pos >= c.size) return false;
+  uint32_t k = pos / c.blockSize;
+  uint32_t from = textRawU32(c, TZ_HEADER_SIZE + k * 4), to = textRawU32(c, TZ_HEADER_SIZE + k * 4 + 4);
+  uint32_t start = k * c.blockSize;
+  uint16_t len = min((uint32_t)c.blockSize, c.size - start);
+  c.block->len = 0;
+  if (!lzUnpack(c, from, to, c.block->data, len)) return false;
+  c.block->start = start;
+  c.block->len = len;
+  return true;
+}
+
+// .tz открывается только курсором с буфером блока (block), остальные файлы - как есть
+bool textOpen(TextCursor& c, const String& path) {
+  FsLock lock;
+  c.file = LittleFS.open(path, "r");
+  c.rawSize = c.size = c.file ? c.file.size() : 0;
+  c.bufLen = 0;
+  c.packed = false;
+  if (!c.file) return false;
+  if (c.rawSize >= TZ_HEADER_SIZE && textRawByteAt(c, 0) == 'T' && textRawByteAt(c, 1) == 'T' && textRawByteAt(c, 2) == 'Z') {
+    c.blockSize = textRawByteAt(c, 8) | (textRawByteAt(c, 9) << 8);
+    if (!c.block || textRawByteAt(c, 3) != TZ_VERSION || !c.blockSize || c.blockSize > TZ_BLOCK_MAX) { c.file.close(); return false; }
+    c.size = textRawU32(c, 4);
+    c.packed = true;
+    c.block->len = 0;
+  }
+  return true;
+}
+
+// Байт текста по смещению или -1 за концом; для .tz - из распакованного блока
+int textByteAt(TextCursor& c, uint32_t pos) {
+  if (!c.packed) return textRawByteAt(c, pos);
+  if (pos - c.block->start >= c.block->len && !textUnpackBlock(c, pos)) return -1;
+  return c.block->data[pos - c.block->start];
 }
 
-void drawTextPage(bool storeHistory = true) {
-  if (storeHistory) {
-    if (readerApp.currentHistoryIndex < readerApp.MAX_PAGE_HISTORY - 1) {
-        readerApp.currentHistoryIndex++;
-        readerApp.pageHistory[readerApp.currentHistoryIndex] = readerFile.position();
-        readerApp.totalPages = readerApp.currentHistoryIndex;
+// Кусок текста в out целиком, без побайтового разбора; возвращает прочитанное
+uint16_t textRead(TextCursor& c, uint32_t pos, uint8_t* out, uint16_t len) {
+  if (pos >= c.size) return 0;
+  len = min((uint32_t)len, c.size - pos);
+  if (!c.packed) { FsLock lock; c.bufLen = 0; c.file.seek(pos); return c.file.read(out, len); }
+  uint16_t n = 0;
+  while (n < len) {
+    if (pos + n - c.block->start >= c.block->len && !textUnpackBlock(c, pos + n)) break;
+    uint16_t part = min((uint32_t)(len - n), c.block->start + c.block->len - (pos + n));
+    memcpy(out + n, c.block->data + (pos + n - c.block->start), part);
+    n += part;
+  }
+  return n;
+}
+
+uint32_t textSkipSpace(TextCursor& c, uint32_t pos) {
+  for (int ch = textByteAt(c, pos); ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n'; ch = textByteAt(c, ++pos)) {}
+  return pos;
+}
+
+// Символ UTF-8 с pos в том виде, который умеет шрифт GyverOLED: ASCII и кириллица как есть,
+// типографские знаки - ближайшим ASCII, остальное - '?'. Пишет байты в out, в srcLen -
+// сколько байт символ занимал в файле. Возвращает ширину в знакоместах, 0 - конец файла
+uint8_t textGlyphAt(TextCursor& c, uint32_t pos, char* out, uint8_t& outLen, uint8_t& srcLen) {
+  int b0 = textByteAt(c, pos);
+  if (b0 < 0) return 0;
+  srcLen = 1; outLen = 1;
+  if (b0 < 0x80) { out[0] = (b0 == '\t' || b0 == '\r') ? ' ' : b0; return 1; }
+  uint8_t need = b0 >= 0xF0 ? 3 : b0 >= 0xE0 ? 2 : b0 >= 0xC0 ? 1 : 0;
+  uint32_t cp = b0 & (0x3F >> need);
+  for (uint8_t i = 1; i <= need; i++) {
+    int b = textByteAt(c, pos + i);
+    if (b < 0 || (b & 0xC0) != 0x80) { need = 0; break; }  // битая последовательность
+    cp = (cp << 6) | (b & 0x3F);
+  }
+  if (!need) { out[0] = '?'; return 1; }
+  srcLen = need + 1;
+  if (cp == 0x401 || cp == 0x451 || (cp >= 0x410 && cp <= 0x44F)) {
+    out[0] = b0; out[1] = textByteAt(c, pos + 1); outLen = 2; return 1;
+  }
+  switch (cp) {
+    case 0xA0: out[0] = ' '; break;
+    case 0xAB: case 0xBB: case 0x201C: case 0x201D: case 0x201E: out[0] = '"'; break;
+    case 0x2018: case 0x2019: out[0] = '\''; break;
+    case 0x2010: case 0x2013: case 0x2014: case 0x2212: out[0] = '-'; break;
+    case 0x2116: out[0] = 'N'; break;
+    case 0x2026: out[0] = out[1] = out[2] = '.'; outLen = 3; return 3;
+    default: out[0] = '?'; break;
+  }
+  return 1;
+}
+
+// Одна экранная строка с pos: ширина считается в знакоместах, перенос по последнему
+// пробелу, слово длиннее строки режется по границе символа. Без выделения памяти:
+// out - буфер вызывающего на READER_LINE_BYTES. Возвращает смещение сразу за строкой
+#define READER_LINE_BYTES (READER_COLS * 2 + 1)
+
+uint32_t textLayoutLine(TextCursor& c, uint32_t pos, char* out, uint8_t& outLen) {
+  uint8_t cols = 0, bytes = 0, breakBytes = 0;
+  uint32_t used = 0, breakUsed = 0;
+  for (;;) {
+    char glyph[3];
+    uint8_t glyphLen, srcLen;
+    uint8_t width = textGlyphAt(c, pos + used, glyph, glyphLen, srcLen);
+    if (!width || glyph[0] == '\n') break;
+    if (cols + width > READER_COLS) {
+      if (glyph[0] != ' ' && breakBytes) { bytes = breakBytes; used = breakUsed; }
+      break;
     }
+    if (glyph[0] == ' ') { breakBytes = bytes; breakUsed = used; }
+    memcpy(out + bytes, glyph, glyphLen);
+    bytes += glyphLen; used += srcLen; cols += width;
   }
-  oled.clear();
-  oled.home();
-  oled.setScale(1); 
+  while (bytes && out[bytes - 1] == ' ') bytes--;
+  outLen = bytes;
+  return pos + used;
+}
 
-  const uint8_t maxCharsPerLine = 21; 
-  uint8_t currentLine = 0;
+// Не больше maxCols знакомест из строки UTF-8 (кириллица - 2 байта на знак)
+void oledPrintCols(const char* s, uint8_t maxCols) {
+  for (uint8_t cols = 0; *s; s++) {
+    if ((*s & 0xC0) != 0x80 && cols++ == maxCols) break;
+    oled.write((uint8_t)*s);
+  }
+}
 
-  oled.setCursor(0, 0);
-  oled.print(readerFile.name());
-  
-  while (readerFile.available() && currentLine < 7) { 
-    String line = readerFile.readStringUntil('\n');
-    line.trim();
-
-    while (line.length() > 0 && currentLine < 7) {
-      if (line.length() <= maxCharsPerLine) {
-        oled.setCursor(0, currentLine + 1);
-        oled.print(line);
-        currentLine++;
-        line = "";
-      } else {
-        int breakPoint = -1;
-        for (int i = maxCharsPerLine; i >= 0; i--) {
-          if (line.charAt(i) == ' ') {
-            breakPoint = i;
-            break;
-          }
-        }
+// Раскладывает страницу с pos (render - еще и рисует строки 1..7). Возвращает начало следующей
+uint32_t textLayoutPage(TextCursor& c, uint32_t pos, bool render) {
+  char line[READER_LINE_BYTES];
+  for (uint8_t row = 0; row < READER_LINES && pos < c.size; row++) {
+    uint8_t len;
+    uint32_t next = textLayoutLine(c, pos, line, len);
+    if (render) { line[len] = 0; oled.setCursor(0, row + 1); oled.print(line); }
+    pos = textSkipSpace(c, next);
+  }
+  return pos;
+}
 
-        String partToPrint;
-        if (breakPoint != -1) {
-          partToPrint = line.substring(0, breakPoint);
-          line = line.substring(breakPoint + 1);
-          line.trim(); 
-        } else {
-          partToPrint = line.substring(0, maxCharsPerLine);
-          line = line.substring(maxCharsPerLine);
-        }
-        
-        oled.setCursor(0, currentLine + 1);
-        oled.print(partToPrint);
-        currentLine++;
-      }
+// Индекс страниц хранится рядом с книгой в /.<имя>.idx и действителен, пока
+// совпадают размер и время изменения файла и версия раскладки
+struct ReaderIndexHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t stride;
+  uint32_t fileSize, fileTime;
+  uint32_t totalPages, scanPos, lastPage;
+  uint16_t checkpointCount;
+  uint8_t complete;
+  uint8_t reserved;
+};
+
+void readerIndexReset() {
+  ReaderAppState& r = readerApp;
+  r.checkpointCount = 0; r.stride = 1; r.totalPages = 0;
+  r.scanPos = textSkipSpace(readerScan, 0);
+  r.indexComplete = false; r.indexDirty = true;
+}
+
+// Размечает одну страницу с scanPos
+void readerIndexNextPage() {
+  ReaderAppState& r = readerApp;
+  if (r.scanPos >= readerScan.size) { r.indexComplete = true; r.indexDirty = true; return; }
+  if (r.totalPages % r.stride == 0) {
+    if (r.checkpointCount == ReaderAppState::MAX_CHECKPOINTS) {
+      for (uint16_t i = 0; i < r.checkpointCount / 2; i++) r.checkpoints[i] = r.checkpoints[i * 2];
+      r.checkpointCount /= 2; r.stride *= 2;
     }
+    if (r.totalPages % r.stride == 0) r.checkpoints[r.checkpointCount++] = r.scanPos;
   }
-  oled.update();
+  r.scanPos = textLayoutPage(readerScan, r.scanPos, false);
+  r.totalPages++;
+  r.indexDirty = true;
 }
 
-// НОВАЯ ФУНКЦИЯ: Для отображения .h файлов
-void viewHFile(String filename) {
-    String fullPath = "/" + filename;
-    File file = LittleFS.open(fullPath.c_str(), "r");
-    if (!file) {
-        showMessage("Ошибка файла!");
-        delay(1000);
-        readerApp.inFileReader = false;
-        drawReaderFileMenu();
-        return;
+// Размечает страницы до готовности страницы page; false - такой страницы нет
+bool readerEnsurePage(uint32_t page) {
+  while (!readerApp.indexComplete && readerApp.totalPages <= page) readerIndexNextPage();
+  return page < readerApp.totalPages;
+}
+
+// page < totalPages: от ближайшей контрольной точки не больше stride-1 страниц пересчета
+uint32_t readerPageOffset(uint32_t page) {
+  ReaderAppState& r = readerApp;
+  uint32_t pos = r.checkpoints[page / r.stride];
+  for (uint32_t p = page / r.stride * r.stride; p < page; p++) pos = textLayoutPage(readerText, pos, false);
+  return pos;
+}
+
+// Поля заголовка должны сходиться между собой: иначе readerPageOffset() выйдет за checkpoints.
+// Файл индекса - обычный dot-файл, его можно залить через /upload
+bool readerIndexHeaderSane(const ReaderIndexHeader& h, uint32_t fileSize) {
+  return h.stride && (h.stride & (h.stride - 1)) == 0 && h.checkpointCount <= ReaderAppState::MAX_CHECKPOINTS &&
+         h.checkpointCount == h.totalPages / h.stride + (h.totalPages % h.stride != 0) &&
+         h.scanPos <= fileSize && (!h.complete || h.scanPos >= fileSize);
+}
+
+bool readerLoadIndex() {
+  ReaderAppState& r = readerApp;
+  FsLock lock;
+  File f = LittleFS.open(readerIndexPath(r.bookName), "r");
+  if (!f) return false;
+  ReaderIndexHeader h;
+  bool ok = f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) && h.magic == READER_INDEX_MAGIC &&
+            h.version == READER_LAYOUT_VERSION && h.fileSize == r.fileSize && h.fileTime == r.fileTime &&
+            readerIndexHeaderSane(h, r.fileSize) &&
+            f.read((uint8_t*)r.checkpoints, h.checkpointCount * sizeof(uint32_t)) == h.checkpointCount * sizeof(uint32_t);
+  f.close();
+  if (!ok) return false;
+  r.stride = h.stride; r.checkpointCount = h.checkpointCount;
+  r.totalPages = h.totalPages; r.scanPos = h.scanPos; r.indexComplete = h.complete;
+  r.page = h.lastPage < h.totalPages ? h.lastPage : 0;
+  r.savedPage = r.page; r.indexDirty = false;
+  return true;
+}
+
+// При закрытии книги и по окончании разметки: незаконченный индекс тоже сохраняется
+// и достраивается со scanPos при следующем открытии
+void readerSaveIndex() {
+  ReaderAppState& r = readerApp;
+  if (!r.indexDirty && r.page == r.savedPage) return;
+  FsLock lock;
+  File f = LittleFS.open(readerIndexPath(r.bookName), "w");
+  if (!f) return;
+  ReaderIndexHeader h = { READER_INDEX_MAGIC, READER_LAYOUT_VERSION, r.stride, r.fileSize, r.fileTime,
+                          r.totalPages, r.scanPos, r.page, r.checkpointCount, r.indexComplete, 0 };
+  f.write((const uint8_t*)&h, sizeof(h));
+  f.write((const uint8_t*)r.checkpoints, r.checkpointCount * sizeof(uint32_t));
+  f.close();
+  r.indexDirty = false; r.savedPage = r.page;
+}
+
+void readerDrawPage() {
+  ReaderAppState& r = readerApp;
+  oled.clear();
+  oled.setScale(1);
+  char info[24];
+  uint8_t percent = r.fileSize ? (uint64_t)r.pagePos * 100 / r.fileSize : 100;
+  const char* title = r.bookName.c_str();
+  ReaderSearch& s = readerSearch;
+  if (s.hitMode) {
+    snprintf(info, sizeof(info), "%u/%u%s %u%%", s.hit + 1, s.hitCount, s.totalHits > s.hitCount ? "+" : "", percent);
+    title = (const char*)s.pattern;
+  } else if (r.pagePending) snprintf(info, sizeof(info), "?/.. %u%%", percent);
+  else if (r.indexComplete) snprintf(info, sizeof(info), "%lu/%lu %u%%", (unsigned long)r.page + 1, (unsigned long)r.totalPages, percent);
+  else snprintf(info, sizeof(info), "%lu/.. %u%%", (unsigned long)r.page + 1, percent);
+  uint8_t infoLen = strlen(info);
+  oled.setCursor(0, 0); oledPrintCols(title, READER_COLS - 1 - infoLen);
+  oled.setCursor(OLED_WIDTH - infoLen * 6, 0); oled.print(info);
+  textLayoutPage(readerText, r.pagePos, true);
+  oledFlush();
+}
+
+void readerDrawJump() {
+  ReaderAppState& r = readerApp;
+  oled.clear();
+  oled.setCursor(0, 0); oled.print("Перейти к странице"); oled.line(0, 10, 127, 10);
+  oled.setScale(2); oled.setCursor(10, 3); oled.print(r.jumpTarget + 1); oled.setScale(1);
+  oled.setCursor(10, 5); oled.print("из "); oled.print(r.totalPages); if (!r.indexComplete) oled.print("+");
+  oled.setCursor(0, 6); oled.print("ВВЕРХ/ВНИЗ: 1, <>: 10");
+  oled.setCursor(0, 7); oled.print("SELECT: ок EXIT: нет");
+  oledFlush();
+}
+
+bool readerGoTo(uint32_t page) {
+  if (!readerEnsurePage(page)) return false;
+  readerApp.page = page;
+  readerApp.pagePos = readerPageOffset(page);
+  readerApp.pagePending = false;
+  readerDrawPage();
+  return true;
+}
+
+// Соседняя страница. Пока номер неизвестен (pagePending), вперед - по раскладке от pagePos,
+// назад некуда: предыдущая граница страницы станет известна только из индекса
+void readerPageStep(int step) {
+  ReaderAppState& r = readerApp;
+  if (!r.pagePending) { if (step > 0 || r.page > 0) readerGoTo(r.page + step); return; }
+  if (step < 0) return;
+  uint32_t next = textLayoutPage(readerText, r.pagePos, false);
+  if (next < readerText.size) { r.pagePos = next; readerDrawPage(); }
+}
+
+#ifdef READER_BENCHMARK
+// Скорость раскладки открываемой книги: только разметка и разметка с отрисовкой в буфер
+// дисплея (без передачи по I2C). Результат - в Serial
+void readerBenchmark() {
+  uint32_t heap = ESP.getFreeHeap();
+  uint32_t pages = 0, start = micros();
+  for (uint32_t pos = textSkipSpace(readerScan, 0); pos < readerScan.size; pages++) pos = textLayoutPage(readerScan, pos, false);
+  uint32_t layoutUs = max(1UL, (unsigned long)(micros() - start));
+  start = micros();
+  for (uint32_t pos = textSkipSpace(readerText, 0); pos < readerText.size;) { oled.clear(); pos = textLayoutPage(readerText, pos, true); }
+  uint32_t renderUs = max(1UL, (unsigned long)(micros() - start));
+  oled.clear();
+  Serial.printf("Reader %s: %lu B, %lu pages, layout %lu pages/s, layout+render %lu pages/s, heap delta %ld\n",
+                readerApp.bookName.c_str(), (unsigned long)readerText.size, (unsigned long)pages,
+                (unsigned long)((uint64_t)pages * 1000000 / layoutUs), (unsigned long)((uint64_t)pages * 1000000 / renderUs),
+                (long)ESP.getFreeHeap() - (long)heap);
+}
+#endif
+
+bool readerOpenBook(const String& filename) {
+  ReaderAppState& r = readerApp;
+  String path = "/" + filename;
+  readerText.block = &readerTextBlock; readerScan.block = &readerScanBlock;
+  if (!textOpen(readerText, path) || !textOpen(readerScan, path)) { FsLock lock; readerText.file.close(); readerScan.file.close(); return false; }
+  if (readerText.packed) {
+    uint32_t start = micros();
+    textByteAt(readerText, 0);
+    Serial.printf("%s: %lu B packed, %lu B text (%lu%%), block %u B unpacked in %lu us\n", filename.c_str(),
+                  (unsigned long)readerText.rawSize, (unsigned long)readerText.size,
+                  (unsigned long)((uint64_t)readerText.rawSize * 100 / max(1UL, (unsigned long)readerText.size)),
+                  readerText.blockSize, (unsigned long)(micros() - start));
+  }
+  r.bookName = filename;
+  r.fileSize = readerText.size;
+  { FsLock lock; r.fileTime = readerText.file.getLastWrite(); }
+  r.view = READER_VIEW_PAGE;
+  r.pagePending = false;
+  readerSearch.hitMode = false; readerSearch.hitCount = 0;  // совпадения относятся к прошлой книге, запрос остается
+#ifdef READER_BENCHMARK
+  readerBenchmark();
+#endif
+  if (!readerLoadIndex()) { readerIndexReset(); r.page = 0; r.savedPage = 0; }
+  // Первая (или сохраненная) страница размечается сразу, остальное - в фоне
+  if (!readerGoTo(r.page)) { r.page = 0; r.pagePos = r.scanPos; readerDrawPage(); }
+  return true;
+}
+
+void readerCloseBook() {
+  readerSaveIndex();
+  FsLock lock;
+  readerText.file.close();
+  readerScan.file.close();
+}
+
+void handleReaderJump() {
+  ReaderAppState& r = readerApp;
+  if (exitBtn.isClick()) { r.view = READER_VIEW_PAGE; readerDrawPage(); return; }
+  if (selectBtn.isClick()) { r.view = READER_VIEW_PAGE; if (!readerGoTo(r.jumpTarget)) readerDrawPage(); return; }
+  uint32_t last = r.totalPages ? r.totalPages - 1 : 0;
+  uint32_t target = r.jumpTarget;
+  if (upBtn.isRepeat(READER_JUMP_REPEAT)) target = min(target + 1, last);
+  if (downBtn.isRepeat(READER_JUMP_REPEAT)) target = target > 0 ? target - 1 : 0;
+  if (rightBtn.isRepeat(READER_JUMP_REPEAT)) target = min(target + 10, last);
+  if (leftBtn.isRepeat(READER_JUMP_REPEAT)) target = target > 10 ? target - 10 : 0;
+  if (target != r.jumpTarget) { r.jumpTarget = target; readerDrawJump(); }
+}
+
+// --- Поиск по книге ---
+// Запрос набирается кнопками из алфавита ввода. Книга читается кусками в фиксированный
+// буфер readerSearch.buf. Каждый кусок приводится к нижнему регистру (ASCII и кириллица
+// UTF-8) и проверяется алгоритмом Бойера-Мура-Хорспула. Хвост куска короче запроса
+// переносится в начало следующего. При смене регистра кириллица остается двумя байтами,
+// поэтому смещения совпадений совпадают со смещениями в тексте. Поиск идет порциями
+// по READER_SEARCH_BUDGET_MS за проход loop(); EXIT прерывает, найденное остается.
+// Итог со скоростью висит до нажатия кнопки или READER_SEARCH_RESULT_MS.
+#define SEARCH_ALPHABET 70            // а-я с ё, a-z, 0-9, пробел
+#define READER_SEARCH_BUDGET_MS 20
+#define READER_SEARCH_RESULT_MS 1500
+
+// Символ алфавита ввода в UTF-8, возвращает длину
+uint8_t searchCharUtf8(uint8_t idx, uint8_t* out) {
+  uint16_t cp;
+  if (idx < 33) cp = idx == 6 ? 0x451 : 0x430 + idx - (idx > 6);
+  else if (idx < 59) cp = 'a' + idx - 33;
+  else if (idx < 69) cp = '0' + idx - 59;
+  else cp = ' ';
+  if (cp < 0x80) { out[0] = cp; return 1; }
+  out[0] = 0xC0 | (cp >> 6); out[1] = 0x80 | (cp & 0x3F);
+  return 2;
+}
+
+// Нижний регистр на месте: A-Z, А-Я и Ё. Ведущий 0xD0 в конце куска не трогается (если
+// кусок не последний): его пара придет со следующим. Возвращает число готовых байт
+uint16_t searchFold(uint8_t* p, uint16_t n, bool last) {
+  for (uint16_t i = 0; i < n; i++) {
+    uint8_t b = p[i];
+    if (b >= 'A' && b <= 'Z') p[i] = b + 32;
+    else if (b == 0xD0) {
+      if (i + 1 == n) return last ? n : i;
+      uint8_t t = p[++i];
+      if (t >= 0x90 && t <= 0x9F) p[i] = t + 0x20;
+      else if (t >= 0xA0 && t <= 0xAF) { p[i - 1] = 0xD1; p[i] = t - 0x20; }
+      else if (t == 0x81) { p[i - 1] = 0xD1; p[i] = 0x91; }
     }
-    uint8_t *img = new uint8_t[1024]; // 128x64 / 8 = 1024
-    if (parseHFile(img, file) != 0) { // Если парсинг не удался
-        delete[] img; 
-        file.close(); 
-        showMessage("Ошибка .h");
-        delay(1000);
-        readerApp.inFileReader = false;
-        drawReaderFileMenu();
-        return;
+  }
+  return n;
+}
+
+void readerSearchPattern() {
+  ReaderSearch& s = readerSearch;
+  s.patternLen = 0;
+  for (uint8_t i = 0; i < s.queryLen; i++) s.patternLen += searchCharUtf8(s.query[i], s.pattern + s.patternLen);
+  s.pattern[s.patternLen] = 0;
+}
+
+void readerDrawQuery() {
+  ReaderSearch& s = readerSearch;
+  readerSearchPattern();
+  oled.clear();
+  oled.setCursor(0, 0); oled.print("Поиск"); oled.line(0, 10, 127, 10);
+  oled.setCursor(0, 3); oled.print((const char*)s.pattern);
+  uint8_t x = (s.queryLen - 1) * 6;
+  oled.line(x, 33, x + 4, 33);
+  oled.setCursor(0, 5); oled.print("ВВЕРХ/ВНИЗ: буква");
+  oled.setCursor(0, 6); oled.print(">: еще <: стереть");
+  oled.setCursor(0, 7); oled.print("SELECT: ок EXIT: нет");
+  oledFlush();
+}
+
+void readerDrawSearch() {
+  ReaderSearch& s = readerSearch;
+  oled.clear();
+  oled.setCursor(0, 0); oled.print("Поиск: "); oledPrintCols((const char*)s.pattern, READER_COLS - 7);
+  oled.line(0, 10, 127, 10);
+  oled.setCursor(0, 3); oled.print(readerScan.size ? (uint64_t)s.readPos * 100 / readerScan.size : 100); oled.print("%");
+  oled.setCursor(0, 4); oled.print("Найдено: "); oled.print(s.totalHits);
+  if (s.doneMs) { oled.setCursor(0, 5); oled.print(s.kbps); oled.print(" КБ/с"); }
+  oled.setCursor(0, 7); oled.print(s.doneMs ? "Любая кнопка: далее" : "EXIT: стоп");
+  oledFlush();
+}
+
+void readerSearchStart() {
+  ReaderSearch& s = readerSearch;
+  readerSearchPattern();
+  memset(s.skip, s.patternLen, sizeof(s.skip));
+  for (uint8_t i = 0; i + 1 < s.patternLen; i++) s.skip[s.pattern[i]] = s.patternLen - 1 - i;
+  s.bufLen = 0; s.bufBase = 0; s.readPos = 0;
+  s.hitCount = 0; s.totalHits = 0; s.hit = 0; s.hitMode = false;
+  s.shownPercent = 0;
+  s.startMs = millis(); s.doneMs = 0;
+  readerApp.view = READER_VIEW_SEARCH;
+  readerDrawSearch();
+}
+
+// Один кусок: дочитать буфер, привести к нижнему регистру, прогнать BMH.
+// false - текст кончился
+bool readerSearchStep() {
+  ReaderSearch& s = readerSearch;
+  uint16_t n = textRead(readerScan, s.readPos, s.buf + s.bufLen, SEARCH_BUF - s.bufLen);
+  bool last = s.readPos + n >= readerScan.size;
+  n = searchFold(s.buf + s.bufLen, n, last);
+  s.readPos += n;
+  uint16_t total = s.bufLen + n, i = 0, m = s.patternLen;
+  while (i + m <= total) {
+    uint8_t tail = s.buf[i + m - 1];
+    if (tail == s.pattern[m - 1] && !memcmp(s.buf + i, s.pattern, m - 1)) {
+      if (s.hitCount < SEARCH_MAX_HITS) s.hits[s.hitCount++] = s.bufBase + i;
+      s.totalHits++;
+      i += m;
+    } else i += s.skip[tail];
+  }
+  memmove(s.buf, s.buf + i, total - i);
+  s.bufBase += i; s.bufLen = total - i;
+  return !last && n;
+}
+
+bool readerIndexCovers(uint32_t pos) { return readerApp.indexComplete || readerApp.scanPos > pos; }
+
+// Страница, на которой начинается смещение pos; только если readerIndexCovers(pos):
+// от контрольной точки не больше stride страниц пересчета
+uint32_t readerPageOf(uint32_t pos) {
+  ReaderAppState& r = readerApp;
+  uint16_t lo = 0, hi = r.checkpointCount;
+  while (hi - lo > 1) { uint16_t mid = (lo + hi) / 2; if (r.checkpoints[mid] <= pos) lo = mid; else hi = mid; }
+  uint32_t page = lo * r.stride, at = r.checkpoints[lo];
+  while (page + 1 < r.totalPages) {
+    uint32_t next = textLayoutPage(readerText, at, false);
+    if (next > pos) break;
+    at = next; page++;
+  }
+  return page;
+}
+
+// Совпадение в размеченной части - его страница. Дальше разметки книга открывается прямо
+// с совпадения (от пробела перед ним, если он в пределах двух строк), а номер страницы
+// найдет фоновая разметка своими порциями, не замораживая интерфейс
+void readerGoToHit(uint16_t hit) {
+  ReaderAppState& r = readerApp;
+  uint32_t pos = readerSearch.hits[hit];
+  readerSearch.hit = hit;
+  if (readerIndexCovers(pos)) { readerGoTo(readerPageOf(pos)); return; }
+  uint32_t start = pos;
+  for (uint32_t p = pos > READER_COLS * 2 ? pos - READER_COLS * 2 : 0; p < pos; p++) {
+    int ch = textByteAt(readerText, p);
+    if (ch == ' ' || ch == '\n') start = p + 1;
+  }
+  r.pagePos = start;
+  r.pagePending = true;
+  readerDrawPage();
+}
+
+// Итог в Serial и на экран; дальше - первое совпадение не раньше текущей страницы
+// Поиск окончен или прерван: итог со скоростью остается на экране, loop() не ждет
+void readerSearchDone() {
+  ReaderSearch& s = readerSearch;
+  uint32_t now = millis();
+  uint32_t ms = max(1UL, (unsigned long)(now - s.startMs));
+  s.kbps = (uint64_t)s.readPos * 1000 / ms / 1024;
+  Serial.printf("Search \"%s\": %lu hits, %lu B in %lu ms, %lu KB/s%s\n", (const char*)s.pattern, (unsigned long)s.totalHits,
+                (unsigned long)s.readPos, (unsigned long)ms, (unsigned long)s.kbps, readerScan.packed ? " (.tz)" : "");
+  s.doneMs = now ? now : 1;
+  readerDrawSearch();
+}
+
+// Уход с итога: к первому совпадению не раньше текущей страницы
+void readerSearchFinish() {
+  ReaderSearch& s = readerSearch;
+  ReaderAppState& r = readerApp;
+  s.doneMs = 0;
+  r.view = READER_VIEW_PAGE;
+  if (!s.hitCount) { readerDrawPage(); return; }
+  s.hitMode = true;
+  uint16_t hit = 0;
+  while (hit < s.hitCount && s.hits[hit] < r.pagePos) hit++;
+  readerGoToHit(hit < s.hitCount ? hit : 0);
+}
+
+void handleReaderSearch() {
+  ReaderSearch& s = readerSearch;
+  if (s.doneMs) {
+    // Уходит отпускание кнопки; нажатие сбрасывается, чтобы не перелистнуть страницу следом
+    bool any = false;
+    for (uint8_t i = 0; i < INPUT_BUTTONS; i++) { any |= inputButtons[i]->isClick(); inputButtons[i]->consume(); }
+    if (any || millis() - s.doneMs >= READER_SEARCH_RESULT_MS) readerSearchFinish();
+    return;
+  }
+  if (exitBtn.isClick()) { readerSearchDone(); return; }
+  uint32_t start = millis();
+  bool more = true;
+  while (more && millis() - start < READER_SEARCH_BUDGET_MS) more = readerSearchStep();
+  if (!more) { readerSearchDone(); return; }
+  uint8_t percent = (uint64_t)s.readPos * 100 / readerScan.size;
+  if (percent != s.shownPercent) { s.shownPercent = percent; readerDrawSearch(); }
+}
+
+// Набор запроса: ВВЕРХ/ВНИЗ меняют последний символ, > добавляет символ, < стирает
+void handleReaderQuery() {
+  ReaderSearch& s = readerSearch;
+  if (exitBtn.isClick()) { readerApp.view = READER_VIEW_PAGE; readerDrawPage(); return; }
+  if (selectBtn.isClick()) { readerSearchStart(); return; }
+  uint8_t& ch = s.query[s.queryLen - 1];
+  bool changed = true;
+  if (upBtn.isRepeat(READER_LIST_REPEAT)) ch = (ch + 1) % SEARCH_ALPHABET;
+  else if (downBtn.isRepeat(READER_LIST_REPEAT)) ch = (ch + SEARCH_ALPHABET - 1) % SEARCH_ALPHABET;
+  else if (rightBtn.isClick() && s.queryLen < SEARCH_QUERY_CHARS) { s.query[s.queryLen] = ch; s.queryLen++; }
+  else if (leftBtn.isClick() && s.queryLen > 1) s.queryLen--;
+  else changed = false;
+  if (changed) readerDrawQuery();
+}
+
+// Меню книги по SELECT
+const char* const READER_MENU_ITEMS[] = { "Перейти к странице", "Поиск", "К совпадениям" };
+
+uint8_t readerMenuCount() { return readerSearch.hitCount ? 3 : 2; }
+
+void readerDrawMenu() {
+  oled.clear();
+  oled.setCursor(0, 0); oledPrintCols(readerApp.bookName.c_str(), READER_COLS); oled.line(0, 10, 127, 10);
+  for (uint8_t i = 0; i < readerMenuCount(); i++) {
+    oled.setCursor(10, 2 + i); oled.print(READER_MENU_ITEMS[i]);
+    if (i == 2) { oled.print(" "); oled.print(readerSearch.hitCount); }
+  }
+  oled.setCursor(0, 2 + readerApp.menuCursor); oled.print(">");
+  oledFlush();
+}
+
+void handleReaderMenu() {
+  ReaderAppState& r = readerApp;
+  ReaderSearch& s = readerSearch;
+  if (exitBtn.isClick()) { r.view = READER_VIEW_PAGE; readerDrawPage(); return; }
+  if (upBtn.isRepeat(READER_LIST_REPEAT) && r.menuCursor > 0) { r.menuCursor--; readerDrawMenu(); }
+  if (downBtn.isRepeat(READER_LIST_REPEAT) && r.menuCursor + 1 < readerMenuCount()) { r.menuCursor++; readerDrawMenu(); }
+  if (!selectBtn.isClick()) return;
+  if (r.menuCursor == 0) { r.view = READER_VIEW_JUMP; r.jumpTarget = r.page; readerDrawJump(); }
+  else if (r.menuCursor == 1) {
+    if (!s.queryLen) { s.query[0] = 0; s.queryLen = 1; }
+    r.view = READER_VIEW_QUERY; readerDrawQuery();
+  } else { r.view = READER_VIEW_PAGE; s.hitMode = true; readerGoToHit(s.hit); }
+}
+
+// --- Картинки .h: разбор один раз в /.<имя>.bin ---
+// .h - C-массив 0xXX в фигурных скобках, 128x64 по страницам (байт page*128 + x, как для
+// drawBitmap). Разбирается через блочный буфер TextCursor при загрузке или первом просмотре
+// и сохраняется уже в порядке буфера GyverOLED (x*8 + page), так что просмотр - одно
+// чтение 1024 байт прямо в кадр.
+#define IMAGE_BYTES (OLED_WIDTH * OLED_PAGES)
+
+int hexDigit(int ch) {
+  if (ch >= '0' && ch <= '9') return ch - '0';
+  ch |= 0x20;
+  return (ch >= 'a' && ch <= 'f') ? ch - 'a' + 10 : -1;
+}
+
+// FsLock - на открытие, блоки чтения (в textByteAt) и запись кэша, разбор идет без него
+bool imageCacheBuild(const String& name) {
+  TextCursor src;
+  if (!textOpen(src, "/" + name)) return false;
+  uint8_t frame[IMAGE_BYTES];
+  memset(frame, 0, sizeof(frame));
+  uint32_t pos = 0;
+  int ch;
+  while ((ch = textByteAt(src, pos++)) >= 0 && ch != '{') {}
+  uint16_t n = 0;
+  while (n < IMAGE_BYTES && (ch = textByteAt(src, pos)) >= 0 && ch != '}') {
+    pos++;
+    if (ch != '0' || (textByteAt(src, pos) | 0x20) != 'x') continue;
+    pos++;
+    uint8_t value = 0;
+    for (uint8_t d = 0; d < 2 && hexDigit(textByteAt(src, pos)) >= 0; d++) value = value * 16 + hexDigit(textByteAt(src, pos++));
+    frame[OLED_BUF_INDEX(n % OLED_WIDTH, n / OLED_WIDTH)] = value;
+    n++;
+  }
+  String path = imageCachePath(name);
+  FsLock lock;
+  src.file.close();
+  if (!n) { if (LittleFS.exists(path)) LittleFS.remove(path); return false; }  // старый кэш не должен пережить сломанный .h
+  File bin = LittleFS.open(path, "w");
+  if (!bin) return false;
+  bool ok = bin.write(frame, sizeof(frame)) == sizeof(frame);
+  bin.close();
+  return ok;
+}
+
+// --- Картинки .tim: сжатый 1bpp формат с анимацией ---
+// Заголовок 10 байт: "TIM", версия 1, ширина, высота (пикс.), число кадров (uint16 LE),
+// интервал кадров в мс (uint16 LE). Дальше кадры: длина данных (uint16 LE) и PackBits
+// (n < 128 - n+1 байт как есть, n > 128 - следующий байт 257-n раз, 128 - пусто) по байтам
+// в порядке страниц: page * ширина + x, как в .h. Декодер пишет прямо в буфер GyverOLED,
+// картинка меньше экрана ставится по центру. Готовит файлы tools/img2tim.py.
+#define TIM_HEADER_SIZE 10
+#define TIM_VERSION 1
+
+bool timOpen(const String& name) {
+  TimPlayer& p = timPlayer;
+  if (!textOpen(p.src, "/" + name)) return false;
+  uint8_t h[TIM_HEADER_SIZE];
+  for (uint8_t i = 0; i < TIM_HEADER_SIZE; i++) { int b = textByteAt(p.src, i); h[i] = b < 0 ? 0 : b; }
+  uint8_t height = h[5];
+  if (memcmp(h, "TIM", 3) || h[3] != TIM_VERSION || !h[4] || h[4] > OLED_WIDTH || !height || height > OLED_PAGES * 8) {
+    FsLock lock;
+    p.src.file.close();
+    return false;
+  }
+  p.width = h[4]; p.pages = (height + 7) / 8;
+  p.frames = h[6] | (h[7] << 8); p.frameMs = h[8] | (h[9] << 8);
+  p.x0 = (OLED_WIDTH - p.width) / 2; p.page0 = (OLED_PAGES - p.pages) / 2;
+  p.firstFrame = p.pos = TIM_HEADER_SIZE; p.frame = 0;
+  return p.frames > 0;
+}
+
+void timClose() { FsLock lock; timPlayer.src.file.close(); timPlayer.frames = 0; }
+
+// Распаковывает очередной кадр в буфер дисплея (без oledFlush), после последнего - снова первый
+bool timDecodeFrame() {
+  TimPlayer& p = timPlayer;
+  uint32_t start = micros();
+  int lo = textByteAt(p.src, p.pos), hi = textByteAt(p.src, p.pos + 1);
+  if (lo < 0 || hi < 0) return false;
+  uint32_t pos = p.pos + 2, end = pos + (lo | (hi << 8));
+  uint16_t out = 0, total = p.width * p.pages;
+  uint8_t x = 0, page = 0;
+  while (pos < end && out < total) {
+    int n = textByteAt(p.src, pos++);
+    if (n < 0) return false;
+    if (n == 128) continue;
+    int count = n < 128 ? n + 1 : 257 - n;
+    int value = n < 128 ? 0 : textByteAt(p.src, pos++);
+    for (; count > 0 && out < total; count--, out++) {
+      if (n < 128) value = textByteAt(p.src, pos++);
+      oled._oled_buffer[OLED_BUF_INDEX(p.x0 + x, p.page0 + page)] = value;
+      if (++x == p.width) { x = 0; page++; }
     }
-    file.close();
+  }
+  p.pos = end;
+  if (++p.frame == p.frames) { p.frame = 0; p.pos = p.firstFrame; }
+  p.decodeUs = micros() - start;
+  return out == total;
+}
+
+// Следующий кадр анимации по часам файла; отстающие кадры пропускаются, темп не плывет
+void timTick() {
+  TimPlayer& p = timPlayer;
+  if (p.frames < 2 || (int32_t)(millis() - p.nextFrameMs) < 0) return;
+  p.nextFrameMs += p.frameMs;
+  if ((int32_t)(millis() - p.nextFrameMs) > 0) p.nextFrameMs = millis() + p.frameMs;
+  if (timDecodeFrame()) oledFlush();
+}
+
+// .tim - первый кадр сразу, дальше анимация из handleReaderImage; .h - из кэша .bin.
+// В Serial: место на флеше и время вывода, для .h отдельно время первого разбора
+bool imageShow(const String& name) {
+  timClose();
+  uint32_t start = micros();
+  if (fileHasExtension(name.c_str(), "tim")) {
+    if (!timOpen(name)) return false;
     oled.clear();
-    oled.drawBitmap(0, 0, img, 128, 64);
-    oled.update();
-    delete[] img;
+    if (!timDecodeFrame()) { timClose(); return false; }
+    timPlayer.nextFrameMs = millis() + timPlayer.frameMs;
+    oledFlush();
+    Serial.printf("%s: %lu B on flash (.h ~%u B), %u frames, decode %lu us/frame\n", name.c_str(),
+                  (unsigned long)timPlayer.src.size, timPlayer.width * timPlayer.pages * 6, timPlayer.frames, (unsigned long)timPlayer.decodeUs);
+    return true;
+  }
+  String path = imageCachePath(name);
+  uint32_t parseUs = 0;
+  bool cached;
+  { FsLock lock; cached = LittleFS.exists(path); }
+  if (!cached) {
+    if (!imageCacheBuild(name)) return false;
+    parseUs = micros() - start;
+  }
+  uint32_t readStart = micros(), readUs, srcSize = 0;
+  bool ok;
+  {
+    FsLock lock;  // кадр уходит на дисплей уже без него
+    File bin = LittleFS.open(path, "r");
+    ok = bin && bin.read(oled._oled_buffer, IMAGE_BYTES) == IMAGE_BYTES;
+    bin.close();
+    readUs = micros() - readStart;
+    File src = LittleFS.open("/" + name, "r");
+    if (src) srcSize = src.size();
+  }
+  if (!ok) return false;
+  oledFlush();
+  Serial.printf("%s: %lu B on flash, parse %lu us, cached view %lu us\n", name.c_str(),
+                (unsigned long)srcSize, (unsigned long)parseUs, (unsigned long)readUs);
+  return true;
+}
+
+// Соседняя картинка в списке читалки (step = +1/-1, по кругу); курсор списка идет следом
+void readerShowNextImage(int step) {
+  String name;
+  {
+    FsLock lock;
+    DirIndex& dir = dirIndexGet();
+    int n = dir.readerCount;
+    for (int i = 1; i <= n; i++) {
+      int idx = ((readerApp.cursor + step * i) % n + n) % n;
+      const DirEntry& e = dir.entries[dir.reader[idx]];
+      if (e.type != FILE_IMAGE) continue;
+      readerApp.cursor = idx;
+      name = dirEntryName(e);
+      break;
+    }
+  }
+  if (name.length()) imageShow(name);
+}
+
+// Просмотр картинки (.tim с анимацией крутится сам): <> - соседние, SELECT - слайд-шоу, ВВЕРХ/ВНИЗ - быстрее/медленнее
+// (интервал 0 - со скоростью дисплея), EXIT - к списку
+void handleReaderImage() {
+  ReaderAppState& r = readerApp;
+  if (exitBtn.isClick()) { r.inFileReader = false; r.slideshow = false; timClose(); drawReaderFileMenu(); return; }
+  timTick();
+  if (selectBtn.isClick()) { r.slideshow = !r.slideshow; r.slideAtMs = millis(); }
+  if (upBtn.isClick()) r.slideMs /= 2;
+  if (downBtn.isClick()) r.slideMs = r.slideMs ? min(r.slideMs * 2, (uint32_t)8000) : 125;
+  int step = 0;
+  if (leftBtn.isRepeat(READER_LIST_REPEAT)) step = -1;
+  if (rightBtn.isRepeat(READER_LIST_REPEAT)) step = 1;
+  if (r.slideshow && millis() - r.slideAtMs >= r.slideMs) step = 1;
+  if (step) { r.slideAtMs = millis(); readerShowNextImage(step); }
+}
+
+// События от веб-сервера, разбираются в loop() на ядре интерфейса
+void webPollEvents() {
+  WebEvent event;
+  while (webState.events && xQueueReceive(webState.events, &event, 0) == pdTRUE) {
+    if (event == WEB_FILES_CHANGED && currentState == READER_APP && !readerApp.inFileReader) {
+      readerApp.filesCount = getReaderFilesCount();
+      if (readerApp.cursor >= readerApp.filesCount) readerApp.cursor = max(0, readerApp.filesCount - 1);
+      drawReaderFileMenu();
+    }
+  }
+}
+
+// Выход из читалки любым путем: индекс открытой книги сохраняется, файлы закрываются
+void exitReaderApp() {
+  FsLock lock;
+  if (readerText.file) readerCloseBook();
+  timClose();
 }
 
 void initReaderApp() {
@@ -1651,30 +3428,58 @@ void initReaderApp() {
   }
 }
 
+// FsLock - только вокруг обращений к файлам, не на весь проход: иначе loop() держал бы
+// его почти непрерывно, и веб-задача на ядре 0 ждала бы, пока открыта читалка
 void handleReaderApp() {
   if (readerApp.inFileReader) {
     // --- РЕЖИМ ПРОСМОТРА ФАЙЛА ---
-    // ИЗМЕНЕНО: Выход по любой кнопке для .h, только EXIT для .txt
-    if (exitBtn.isClick() || selectBtn.isClick()) {
-      if (readerFile) readerFile.close();
-      readerApp.inFileReader = false;
-      drawReaderFileMenu();
-      return;
+    // В тексте SELECT открывает меню книги: переход к странице и поиск
+    if (!readerText.file) { handleReaderImage(); return; }
+    ReaderView view = readerApp.view;
+    if (view == READER_VIEW_SEARCH) { handleReaderSearch(); return; }  // поиск сам делит время, разметка подождет
+    if (view == READER_VIEW_MENU) handleReaderMenu();
+    else if (view == READER_VIEW_JUMP) handleReaderJump();
+    else if (view == READER_VIEW_QUERY) handleReaderQuery();
+    else if (readerSearch.hitMode) {
+      // Совпадения: <> - соседние, EXIT - обычное листание
+      ReaderSearch& s = readerSearch;
+      if (exitBtn.isClick()) { s.hitMode = false; readerDrawPage(); }
+      if (selectBtn.isClick()) { readerApp.view = READER_VIEW_MENU; readerApp.menuCursor = 2; readerDrawMenu(); }
+      if (upBtn.isRepeat(READER_PAGE_REPEAT)) readerPageStep(-1);
+      if (downBtn.isRepeat(READER_PAGE_REPEAT)) readerPageStep(1);
+      if (leftBtn.isRepeat(READER_PAGE_REPEAT) && s.hit > 0) readerGoToHit(s.hit - 1);
+      if (rightBtn.isRepeat(READER_PAGE_REPEAT) && s.hit + 1 < s.hitCount) readerGoToHit(s.hit + 1);
+    } else {
+      if (exitBtn.isClick()) {
+        readerCloseBook();
+        readerApp.inFileReader = false;
+        drawReaderFileMenu();
+        return;
+      }
+      if (selectBtn.isClick()) { readerApp.view = READER_VIEW_MENU; readerApp.menuCursor = 0; readerDrawMenu(); }
+      if (upBtn.isRepeat(READER_PAGE_REPEAT)) readerPageStep(-1);
+      if (downBtn.isRepeat(READER_PAGE_REPEAT)) readerPageStep(1);
+      if (!readerApp.pagePending) {  // +-10 страниц - только от известного номера
+        if (leftBtn.isRepeat(READER_PAGE_REPEAT)) readerGoTo(readerApp.page > 10 ? readerApp.page - 10 : 0);
+        if (rightBtn.isRepeat(READER_PAGE_REPEAT) && !readerGoTo(readerApp.page + 10) && readerApp.totalPages)
+          readerGoTo(readerApp.totalPages - 1);
+      }
     }
-
-    if (readerFile && String(readerFile.name()).endsWith(".txt")) {
-        if (upBtn.isClick() || upBtn.isHold()) {
-            if (readerApp.currentHistoryIndex > 0) {
-                readerApp.currentHistoryIndex--;
-                readerFile.seek(readerApp.pageHistory[readerApp.currentHistoryIndex]);
-                drawTextPage(false);
-            }
-        }
-        if (downBtn.isClick() || downBtn.isHold()) {
-            if (readerFile.available()) {
-                drawTextPage(true);
-            }
-        }
+    // Фоновая разметка остатка книги; по готовности - сохранить индекс и показать число страниц
+    if (!readerApp.indexComplete) {
+      uint32_t start = millis();
+      while (!readerApp.indexComplete && millis() - start < READER_INDEX_BUDGET_MS) readerIndexNextPage();
+      if (readerApp.pagePending && readerIndexCovers(readerApp.pagePos)) {
+        // Разметка дошла до открытого места: номер страницы известен, текст на экране тот же
+        readerApp.page = readerPageOf(readerApp.pagePos);
+        readerApp.pagePending = false;
+        if (readerApp.view == READER_VIEW_PAGE) readerDrawPage();
+      }
+      if (readerApp.indexComplete) {
+        readerSaveIndex();
+        if (readerApp.view == READER_VIEW_JUMP) readerDrawJump();
+        else if (readerApp.view == READER_VIEW_PAGE) readerDrawPage();
+      }
     }
   } else {
     // --- РЕЖИМ ВЫБОРА ФАЙЛА ---
@@ -1682,39 +3487,34 @@ void handleReaderApp() {
         currentState = previousState;
         return;
     }
-    static uint32_t timer = 0;
-    if (upBtn.isClick() || (upBtn.isHold() && millis() - timer > 150)) {
+    if (upBtn.isRepeat(READER_LIST_REPEAT)) {
         if (readerApp.cursor > 0) readerApp.cursor--;
-        timer = millis();
         updateReaderCursor();
     }
-    if (downBtn.isClick() || (downBtn.isHold() && millis() - timer > 150)) {
+    if (downBtn.isRepeat(READER_LIST_REPEAT)) {
         if (readerApp.cursor < readerApp.filesCount - 1) readerApp.cursor++;
-        timer = millis();
         updateReaderCursor();
     }
     if (selectBtn.isClick()) {
         String filename = getReaderFilenameByIndex(readerApp.cursor);
         if (filename != "") {
             readerApp.inFileReader = true;
-            String fullPath = "/" + filename;
-            if (filename.endsWith(".txt")) {
-                readerFile = LittleFS.open(fullPath.c_str(), "r");
-                if (!readerFile) {
+            if (fileTypeOf(filename.c_str()) == FILE_TEXT) {
+                if (!readerOpenBook(filename)) {
                     readerApp.inFileReader = false;
                     showMessage("Ошибка файла!");
                     delay(1000);
                     drawReaderFileMenu();
                     return;
                 }
-                memset(readerApp.pageHistory, 0, sizeof(readerApp.pageHistory));
-                readerApp.currentHistoryIndex = -1;
-                readerApp.totalPages = 0;
-                drawTextPage();
-         
-            } else if (filename.endsWith(".h")) {
-                  //Для .h мы просто отображаем и ждем выхода
-                 viewHFile(filename);
+            } else if (fileTypeOf(filename.c_str()) == FILE_IMAGE) {
+                readerApp.slideshow = false;
+                if (!imageShow(filename)) {
+                    readerApp.inFileReader = false;
+                    showMessage("Ошибка .h");
+                    delay(1000);
+                    drawReaderFileMenu();
+                }
             }
         }
     }
@@ -1723,27 +3523,23 @@ void handleReaderApp() {
 
 // --- Конец функционала читалки ---
 
-void drawMenu(const char* title, const char* items[], int itemCount, int currentPage, int totalPages) {
+void drawMenu(const MenuDescriptor& menu) {
+  const MenuState& state = *menu.state;
   oled.clear();
-  oled.setCursor(0, 0); oled.setScale(1); oled.print(title); oled.line(0, 10, 127, 10);
-  int itemsPerPage = (strcmp(title, "Игры") == 0 || strcmp(title, "Приложения") == 0) ? 5 : 4;
-  int startIndex = currentPage * itemsPerPage;
-  int endIndex = min(startIndex + itemsPerPage, itemCount);
+  oled.setCursor(0, 0); oled.setScale(1); oled.print(menu.title); oled.line(0, 10, 127, 10);
+  int startIndex = state.page * menu.itemsPerPage;
+  int endIndex = min(startIndex + (int)menu.itemsPerPage, (int)menu.itemCount);
   for (int i = startIndex; i < endIndex; i++) {
     int displayIndex = i - startIndex;
-    oled.setCursor(10, 2 + displayIndex); oled.print(items[i]);
-    int currentIndex = 0;
-    if (strcmp(title, "Меню") == 0) currentIndex = mainMenuState.index;
-    else if (strcmp(title, "Настройки") == 0) currentIndex = settingsMenuState.index;
-    else if (strcmp(title, "Мини приложения") == 0) currentIndex = miniAppsMenuState.index;
-    else if (strcmp(title, "Приложения") == 0) currentIndex = appsMenuState.index;
-    else if (strcmp(title, "Игры") == 0) currentIndex = gamesMenuState.index;
-    if (displayIndex == currentIndex) { oled.setCursor(0, 2 + displayIndex); oled.print(">"); }
+    oled.setCursor(10, 2 + displayIndex); oled.print(menu.items[i]);
+    if (displayIndex == state.index) { oled.setCursor(0, 2 + displayIndex); oled.print(">"); }
   }
-  if (totalPages > 1) { oled.setCursor(100, 0); oled.print("("); oled.print(currentPage + 1); oled.print("/"); oled.print(totalPages); oled.print(")"); }
-  oled.update();
+  if (state.maxPages > 1) { oled.setCursor(100, 0); oled.print("("); oled.print(state.page + 1); oled.print("/"); oled.print(state.maxPages); oled.print(")"); }
+  oledFlush();
+  screenDirty = false;
 }
 
 void showMessage(const char* message) {
-  oled.clear(); oled.setCursor(2, 3); oled.setScale(2); oled.print(message); oled.update();
+  screenDirty = true;
+  oled.clear(); oled.setCursor(2, 3); oled.setScale(2); oled.print(message); oledFlush();
 }
@@ -0,0 +1,43 @@
+# Сжимает web/index.html в include/web_index.h (gzip-массив в PROGMEM + ETag).
+# Подключен в platformio.ini как pre-скрипт, можно запускать и вручную: python tools/embed_web.py
+# Заголовок перегенерируется, только если index.html новее; результат хранится в репозитории.
+import gzip
+import hashlib
+import os
+
+try:
+    Import("env")  # noqa: F821 - есть только внутри PlatformIO
+    ROOT = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SRC = os.path.join(ROOT, "web", "index.html")
+DST = os.path.join(ROOT, "include", "web_index.h")
+
+
+def embed():
+    if os.path.exists(DST) and os.path.getmtime(DST) >= os.path.getmtime(SRC):
+        return
+    with open(SRC, "rb") as f:
+        html = f.read()
+    data = gzip.compress(html, compresslevel=9, mtime=0)  # mtime=0: одинаковый вход - одинаковый ETag
+    etag = hashlib.sha1(data).hexdigest()[:16]
+    lines = [
+        "// Сгенерировано tools/embed_web.py из web/index.html, не править вручную",
+        "#pragma once",
+        "#include <Arduino.h>",
+        "",
+        "#define WEB_INDEX_ETAG \"\\\"%s\\\"\"" % etag,
+        "#define WEB_INDEX_GZ_LEN %d  // исходный HTML: %d байт" % (len(data), len(html)),
+        "",
+        "const uint8_t WEB_INDEX_GZ[] PROGMEM = {",
+    ]
+    for i in range(0, len(data), 16):
+        lines.append("  " + ",".join("0x%02X" % b for b in data[i:i + 16]) + ",")
+    lines.append("};")
+    with open(DST, "w", newline="\n") as f:
+        f.write("\n".join(lines) + "\n")
+    print("web_index.h: %d -> %d bytes, ETag %s" % (len(html), len(data), etag))
+
+
+embed()
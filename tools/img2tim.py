@@ -0,0 +1,100 @@
+# Конвертер картинок в .tim для читалки TemaOS (формат описан в src/main.cpp, раздел "Картинки .tim").
+#   python tools/img2tim.py cat.png cat.tim                 - одна картинка (PNG, BMP, ...)
+#   python tools/img2tim.py anim.gif anim.tim --fps 12      - все кадры GIF
+#   python tools/img2tim.py logo.h logo.tim                 - из .h (128x64, 0xXX по страницам)
+# Картинки больше 128x64 уменьшаются с сохранением пропорций; порог --threshold (0-255).
+# В конце печатает размер .tim против того же изображения в виде .h.
+import argparse
+import re
+import struct
+import sys
+
+OLED_W, OLED_H = 128, 64
+
+
+def packbits(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and run < 128 and data[i + run] == data[i]:
+            run += 1
+        if run >= 2:
+            out += bytes([257 - run, data[i]])
+            i += run
+            continue
+        start = i
+        while i < len(data) and i - start < 128:
+            if i + 1 < len(data) and data[i + 1] == data[i]:
+                break
+            i += 1
+        out.append(i - start - 1)
+        out += data[start:i]
+    return bytes(out)
+
+
+def pages_from_image(img, threshold):
+    img = img.convert("L")
+    if img.width > OLED_W or img.height > OLED_H:
+        img.thumbnail((OLED_W, OLED_H))
+    w, h = img.size
+    px = img.load()
+    data = bytearray()
+    for page in range((h + 7) // 8):
+        for x in range(w):
+            byte = 0
+            for bit in range(8):
+                y = page * 8 + bit
+                if y < h and px[x, y] >= threshold:
+                    byte |= 1 << bit
+            data.append(byte)
+    return w, h, bytes(data)
+
+
+def frames_from_h(path):
+    text = open(path, encoding="utf-8", errors="ignore").read()
+    body = text[text.index("{") + 1:]
+    body = body[:body.index("}")] if "}" in body else body
+    data = bytes(int(v, 16) for v in re.findall(r"0[xX]([0-9a-fA-F]{1,2})", body))
+    data = data[:OLED_W * OLED_H // 8].ljust(OLED_W * OLED_H // 8, b"\0")
+    return OLED_W, OLED_H, [data]
+
+
+def frames_from_image(path, threshold):
+    from PIL import Image, ImageSequence  # pip install pillow
+    img = Image.open(path)
+    frames = [pages_from_image(f.copy(), threshold) for f in ImageSequence.Iterator(img)]
+    w, h = frames[0][0], frames[0][1]
+    return w, h, [f[2] for f in frames], img.info.get("duration", 100)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("src")
+    ap.add_argument("dst")
+    ap.add_argument("--fps", type=float, help="частота кадров анимации (по умолчанию из GIF)")
+    ap.add_argument("--threshold", type=int, default=128)
+    args = ap.parse_args()
+
+    if args.src.lower().endswith(".h"):
+        w, h, frames = frames_from_h(args.src)
+        frame_ms = 100
+    else:
+        w, h, frames, frame_ms = frames_from_image(args.src, args.threshold)
+    if args.fps:
+        frame_ms = round(1000 / args.fps)
+
+    out = bytearray(b"TIM" + struct.pack("<BBBHH", 1, w, h, len(frames), frame_ms))
+    for data in frames:
+        packed = packbits(data)
+        out += struct.pack("<H", len(packed)) + packed
+    open(args.dst, "wb").write(out)
+
+    raw = sum(len(f) for f in frames)
+    as_h = raw * 6  # "0xXX, " на каждый байт
+    print("%s: %dx%d, %d frame(s), raw %d B, .tim %d B, .h ~%d B (%.1fx smaller)"
+          % (args.dst, w, h, len(frames), raw, len(out), as_h, as_h / len(out)))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,124 @@
+# Сжимает текст в .tz для читалки TemaOS (формат описан в src/main.cpp, раздел "Сжатый текст .tz").
+#   python tools/txt2tz.py book.txt book.tz
+#   python tools/txt2tz.py book.txt book.tz --block 2048    - блок меньше: быстрее переход, хуже сжатие
+# Блоки сжимаются независимо, поэтому читалка распаковывает только тот, где лежит страница.
+# В конце проверяет распаковку и печатает размер .tz против исходного текста.
+import argparse
+import struct
+import sys
+
+MIN_MATCH = 4
+MAX_CHAIN = 64
+BLOCK_MAX = 4096  # TZ_BLOCK_MAX в прошивке
+
+
+def put_length(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def put_sequence(out, literals, match_len, offset):
+    lit = len(literals)
+    ml = match_len - MIN_MATCH if match_len else 0
+    out.append((min(lit, 15) << 4) | min(ml, 15))
+    if lit >= 15:
+        put_length(out, lit - 15)
+    out += literals
+    if match_len:
+        out += struct.pack("<H", offset)
+        if ml >= 15:
+            put_length(out, ml - 15)
+
+
+def compress_block(data):
+    out = bytearray()
+    heads = {}
+    prev = [-1] * len(data)
+    anchor = i = 0
+    while i + MIN_MATCH <= len(data):
+        key = data[i:i + MIN_MATCH]
+        best_len = best_off = 0
+        j, chain = heads.get(key, -1), MAX_CHAIN
+        while j >= 0 and chain:
+            n = 0
+            while i + n < len(data) and data[j + n] == data[i + n]:
+                n += 1
+            if n > best_len:
+                best_len, best_off = n, i - j
+            j, chain = prev[j], chain - 1
+        if best_len < MIN_MATCH:
+            prev[i], heads[key] = heads.get(key, -1), i
+            i += 1
+            continue
+        put_sequence(out, data[anchor:i], best_len, best_off)
+        for k in range(i, min(i + best_len, len(data) - MIN_MATCH + 1)):
+            key = data[k:k + MIN_MATCH]
+            prev[k], heads[key] = heads.get(key, -1), k
+        i += best_len
+        anchor = i
+    put_sequence(out, data[anchor:], 0, 0)  # последняя последовательность - только литералы
+    return bytes(out)
+
+
+def decompress_block(data, size):
+    out = bytearray()
+    src = 0
+
+    def length(n):
+        nonlocal src
+        if n == 15:
+            while True:
+                b = data[src]
+                src += 1
+                n += b
+                if b != 255:
+                    break
+        return n
+
+    while src < len(data):
+        token = data[src]
+        src += 1
+        lit = length(token >> 4)
+        out += data[src:src + lit]
+        src += lit
+        if src >= len(data):
+            break
+        offset = data[src] | (data[src + 1] << 8)
+        src += 2
+        for _ in range(length(token & 15) + MIN_MATCH):
+            out.append(out[-offset])
+    assert len(out) == size
+    return bytes(out)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("src")
+    ap.add_argument("dst")
+    ap.add_argument("--block", type=int, default=BLOCK_MAX, help="размер блока, до %d" % BLOCK_MAX)
+    args = ap.parse_args()
+    if not 0 < args.block <= BLOCK_MAX:
+        ap.error("--block: 1..%d" % BLOCK_MAX)
+
+    text = open(args.src, "rb").read()
+    blocks = [compress_block(text[i:i + args.block]) for i in range(0, len(text), args.block)]
+    if len(blocks) > 0xFFFF:
+        ap.error("слишком много блоков, увеличьте --block")
+
+    header = b"TTZ" + struct.pack("<BIHH", 1, len(text), args.block, len(blocks))
+    offsets = [len(header) + 4 * (len(blocks) + 1)]
+    for b in blocks:
+        offsets.append(offsets[-1] + len(b))
+    out = header + struct.pack("<%dI" % len(offsets), *offsets) + b"".join(blocks)
+    for k, b in enumerate(blocks):
+        assert decompress_block(b, len(text[k * args.block:(k + 1) * args.block])) == text[k * args.block:(k + 1) * args.block]
+    open(args.dst, "wb").write(out)
+
+    print("%s: %d B text, %d blocks of %d B, .tz %d B (%.0f%%)"
+          % (args.dst, len(text), len(blocks), args.block, len(out), 100.0 * len(out) / max(1, len(text))))
+
+
+if __name__ == "__main__":
+    sys.exit(main())